@@ -98,6 +98,19 @@ if test "$PHP_MONGODB" != "no"; then
     MONGODB_SHARED_LIBADD="$MONGODB_SHARED_LIBADD $COVERAGE_LDFLAGS"
   fi
 
+  PHP_ARG_ENABLE([mongodb-probes],
+                 [whether to enable static tracepoints],
+                 [AS_HELP_STRING([--enable-mongodb-probes],
+                                 [MongoDB: Enable USDT static tracepoints (requires sys/sdt.h) [default=no]])],
+                 [no],
+                 [no])
+
+  if test "$PHP_MONGODB_PROBES" = "yes"; then
+    AC_CHECK_HEADER([sys/sdt.h],
+                    [AC_DEFINE(PHONGO_HAVE_PROBES, 1, [Enable USDT static tracepoints])],
+                    [AC_MSG_ERROR([sys/sdt.h is required for --enable-mongodb-probes (e.g. install systemtap-sdt-devel)])])
+  fi
+
   PHP_MONGODB_CFLAGS="$STD_CFLAGS $MAINTAINER_CFLAGS $COVERAGE_CFLAGS"
 
   PHP_MONGODB_SOURCES="\
@@ -116,7 +129,9 @@ if test "$PHP_MONGODB" != "no"; then
     src/BSON/DBPointer.c \
     src/BSON/Decimal128.c \
     src/BSON/Decimal128Interface.c \
+    src/BSON/Document.c \
     src/BSON/Int64.c \
+    src/BSON/Iterator.c \
     src/BSON/Javascript.c \
     src/BSON/JavascriptInterface.c \
     src/BSON/MaxKey.c \
@@ -125,9 +140,13 @@ if test "$PHP_MONGODB" != "no"; then
     src/BSON/MinKeyInterface.c \
     src/BSON/ObjectId.c \
     src/BSON/ObjectIdInterface.c \
+    src/BSON/PackedArray.c \
     src/BSON/Persistable.c \
+    src/BSON/PropertyCodec.c \
     src/BSON/Regex.c \
     src/BSON/RegexInterface.c \
+    src/BSON/SequenceReader.c \
+    src/BSON/SequenceWriter.c \
     src/BSON/Serializable.c \
     src/BSON/Symbol.c \
     src/BSON/Timestamp.c \
@@ -25,13 +25,23 @@
 #include <ext/standard/info.h>
 
 #include "php_phongo.h"
+#include "src/phongo_bson.h"
+#include "src/phongo_bson_encode.h"
 #include "src/phongo_client.h"
 #include "src/phongo_error.h"
 #include "src/phongo_ini.h"
+#include "src/phongo_probes.h"
 #include "src/BSON/functions.h"
 #include "src/MongoDB/Monitoring/functions.h"
 
 ZEND_DECLARE_MODULE_GLOBALS(mongodb)
+
+#ifdef PHONGO_HAVE_PROBES
+/* Semaphores for the probes declared in phongo_probes.h. Tracers locate them
+ * through the .probes section. */
+#define PHONGO_PROBE_DEFINE_SEMAPHORE(name) unsigned short mongodb_##name##_semaphore __attribute__((section(".probes")));
+PHONGO_PROBE_NAMES(PHONGO_PROBE_DEFINE_SEMAPHORE)
+#endif
 #if defined(ZTS) && defined(COMPILE_DL_MONGODB)
 ZEND_TSRMLS_CACHE_DEFINE();
 #endif
@@ -110,6 +120,43 @@ PHP_RINIT_FUNCTION(mongodb) /* {{{ */
 		zend_hash_init(MONGODB_G(managers), 0, NULL, NULL, 0);
 	}
 
+	/* Initialize HashTable for compiled type maps. This is initialized to NULL
+	 * in GINIT and destroyed and reset to NULL in RSHUTDOWN. Each element owns
+	 * a compiled type map and a reference to the array it was compiled from,
+	 * which are released by the element destructor. */
+	if (MONGODB_G(typemap_cache) == NULL) {
+		ALLOC_HASHTABLE(MONGODB_G(typemap_cache));
+		zend_hash_init(MONGODB_G(typemap_cache), 0, NULL, php_phongo_bson_typemap_cache_dtor, 0);
+	}
+
+	/* Initialize HashTable for ODM classes resolved from "__pclass" fields.
+	 * This is initialized to NULL in GINIT and destroyed and reset to NULL in
+	 * RSHUTDOWN. Since this HashTable stores pointers to class entries (or NULL
+	 * for names that did not resolve to a Persistable class), the element
+	 * destructor is intentionally NULL. */
+	if (MONGODB_G(odm_class_cache) == NULL) {
+		ALLOC_HASHTABLE(MONGODB_G(odm_class_cache));
+		zend_hash_init(MONGODB_G(odm_class_cache), 0, NULL, NULL, 0);
+	}
+
+	/* Initialize HashTable for the encoding types of classes other than the
+	 * driver's own (e.g. classes implementing MongoDB\BSON\Serializable). This
+	 * is initialized to NULL in GINIT and destroyed and reset to NULL in
+	 * RSHUTDOWN. Since this HashTable stores integers, the element destructor
+	 * is intentionally NULL. */
+	if (MONGODB_G(encode_type_cache) == NULL) {
+		ALLOC_HASHTABLE(MONGODB_G(encode_type_cache));
+		zend_hash_init(MONGODB_G(encode_type_cache), 0, NULL, NULL, 0);
+	}
+
+	/* Initialize HashTable for the compiled property maps of classes
+	 * implementing MongoDB\BSON\PropertyCodec. This is initialized to NULL
+	 * in GINIT and destroyed and reset to NULL in RSHUTDOWN. */
+	if (MONGODB_G(property_map_cache) == NULL) {
+		ALLOC_HASHTABLE(MONGODB_G(property_map_cache));
+		zend_hash_init(MONGODB_G(property_map_cache), 0, NULL, php_phongo_bson_property_map_dtor, 0);
+	}
+
 	return SUCCESS;
 } /* }}} */
 
@@ -203,6 +250,7 @@ PHP_MINIT_FUNCTION(mongodb) /* {{{ */
 	php_phongo_type_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 	php_phongo_serializable_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 	php_phongo_unserializable_init_ce(INIT_FUNC_ARGS_PASSTHRU);
+	php_phongo_propertycodec_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 
 	php_phongo_binary_interface_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 	php_phongo_decimal128_interface_init_ce(INIT_FUNC_ARGS_PASSTHRU);
@@ -214,16 +262,25 @@ PHP_MINIT_FUNCTION(mongodb) /* {{{ */
 	php_phongo_timestamp_interface_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 	php_phongo_utcdatetime_interface_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 
+	/* Iterator must be registered before the classes returning it from
+	 * getIterator(), so that their return types can be checked against
+	 * IteratorAggregate. */
+	php_phongo_iterator_init_ce(INIT_FUNC_ARGS_PASSTHRU);
+
 	php_phongo_binary_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 	php_phongo_dbpointer_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 	php_phongo_decimal128_init_ce(INIT_FUNC_ARGS_PASSTHRU);
+	php_phongo_document_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 	php_phongo_int64_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 	php_phongo_javascript_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 	php_phongo_maxkey_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 	php_phongo_minkey_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 	php_phongo_objectid_init_ce(INIT_FUNC_ARGS_PASSTHRU);
+	php_phongo_packedarray_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 	php_phongo_persistable_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 	php_phongo_regex_init_ce(INIT_FUNC_ARGS_PASSTHRU);
+	php_phongo_sequencereader_init_ce(INIT_FUNC_ARGS_PASSTHRU);
+	php_phongo_sequencewriter_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 	php_phongo_symbol_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 	php_phongo_timestamp_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 	php_phongo_undefined_init_ce(INIT_FUNC_ARGS_PASSTHRU);
@@ -285,6 +342,9 @@ PHP_MINIT_FUNCTION(mongodb) /* {{{ */
 	php_phongo_topologyclosedevent_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 	php_phongo_topologyopeningevent_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 
+	/* Resolve how instances of the classes registered above are encoded */
+	php_phongo_bson_encode_types_init();
+
 	REGISTER_STRING_CONSTANT("MONGODB_VERSION", (char*) PHP_MONGODB_VERSION, CONST_CS | CONST_PERSISTENT);
 	REGISTER_STRING_CONSTANT("MONGODB_STABILITY", (char*) PHP_MONGODB_STABILITY, CONST_CS | CONST_PERSISTENT);
 
@@ -295,6 +355,8 @@ PHP_MSHUTDOWN_FUNCTION(mongodb) /* {{{ */
 {
 	phongo_unregister_ini_entries(SHUTDOWN_FUNC_ARGS_PASSTHRU);
 
+	php_phongo_bson_encode_types_dtor();
+
 	return SUCCESS;
 } /* }}} */
 
@@ -327,6 +389,44 @@ PHP_RSHUTDOWN_FUNCTION(mongodb) /* {{{ */
 		MONGODB_G(managers) = NULL;
 	}
 
+	/* Destroy HashTable for compiled type maps, which was initialized in RINIT.
+	 * Type maps still in use (e.g. by a Cursor that has yet to be freed) hold
+	 * their own reference to the compiled field paths. */
+	if (MONGODB_G(typemap_cache)) {
+		zend_hash_destroy(MONGODB_G(typemap_cache));
+		FREE_HASHTABLE(MONGODB_G(typemap_cache));
+		MONGODB_G(typemap_cache) = NULL;
+	}
+
+	/* Destroy HashTable for ODM classes, which was initialized in RINIT. */
+	if (MONGODB_G(odm_class_cache)) {
+		mongoc_log(MONGOC_LOG_LEVEL_TRACE, MONGOC_LOG_DOMAIN, "ODM class cache: %" PRIu64 " hits, %" PRIu64 " misses", MONGODB_G(odm_class_cache_hits), MONGODB_G(odm_class_cache_misses));
+
+		zend_hash_destroy(MONGODB_G(odm_class_cache));
+		FREE_HASHTABLE(MONGODB_G(odm_class_cache));
+		MONGODB_G(odm_class_cache)        = NULL;
+		MONGODB_G(odm_class_cache_hits)   = 0;
+		MONGODB_G(odm_class_cache_misses) = 0;
+	}
+
+	/* Destroy HashTable for encoding types, which was initialized in RINIT. */
+	if (MONGODB_G(encode_type_cache)) {
+		zend_hash_destroy(MONGODB_G(encode_type_cache));
+		FREE_HASHTABLE(MONGODB_G(encode_type_cache));
+		MONGODB_G(encode_type_cache) = NULL;
+	}
+
+	/* Free the scratch buffer for short-lived BSON documents, which is
+	 * allocated on first use. */
+	php_phongo_bson_scratch_free();
+
+	/* Destroy HashTable for property maps, which was initialized in RINIT. */
+	if (MONGODB_G(property_map_cache)) {
+		zend_hash_destroy(MONGODB_G(property_map_cache));
+		FREE_HASHTABLE(MONGODB_G(property_map_cache));
+		MONGODB_G(property_map_cache) = NULL;
+	}
+
 	return SUCCESS;
 } /* }}} */
 
@@ -469,6 +569,17 @@ PHP_MINFO_FUNCTION(mongodb) /* {{{ */
 	php_info_print_table_row(2, "libmongocrypt", "disabled");
 #endif
 
+	/* Lookups of ODM classes (see php_phongo_bson_fetch_odm_class()) during
+	 * the current request */
+	{
+		char count[24];
+
+		snprintf(count, sizeof(count), "%" PRIu64, MONGODB_G(odm_class_cache_hits));
+		php_info_print_table_row(2, "ODM class cache hits", count);
+		snprintf(count, sizeof(count), "%" PRIu64, MONGODB_G(odm_class_cache_misses));
+		php_info_print_table_row(2, "ODM class cache misses", count);
+	}
+
 	php_info_print_table_end();
 
 	phongo_display_ini_entries(ZEND_MODULE_INFO_FUNC_ARGS_PASSTHRU);
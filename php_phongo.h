@@ -44,12 +44,22 @@
 extern zend_module_entry mongodb_module_entry;
 
 ZEND_BEGIN_MODULE_GLOBALS(mongodb)
-	char*      debug;
-	FILE*      debug_fd;
-	HashTable  persistent_clients;
-	HashTable* request_clients;
-	HashTable* subscribers;
-	HashTable* managers;
+	char*          debug;
+	FILE*          debug_fd;
+	HashTable      persistent_clients;
+	HashTable*     request_clients;
+	HashTable*     subscribers;
+	HashTable*     managers;
+	HashTable*     typemap_cache;
+	HashTable*     odm_class_cache;
+	uint64_t       odm_class_cache_hits;
+	uint64_t       odm_class_cache_misses;
+	HashTable*     encode_type_cache;
+	HashTable*     property_map_cache;
+	bson_writer_t* bson_scratch;
+	uint8_t*       bson_scratch_buf;
+	size_t         bson_scratch_buf_len;
+	bool           bson_scratch_in_use;
 ZEND_END_MODULE_GLOBALS(mongodb)
 
 #define MONGODB_G(v) ZEND_MODULE_GLOBALS_ACCESSOR(mongodb, v)
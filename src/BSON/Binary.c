@@ -25,25 +25,38 @@
 
 #define PHONGO_BINARY_UUID_SIZE 16
 
+/* Vectors (binary subtype 9) start with a two-byte header: the element type
+ * followed by the number of unused bits in the final byte of a packed bit
+ * vector. */
+#define PHONGO_BINARY_SUBTYPE_VECTOR 0x09
+#define PHONGO_BINARY_VECTOR_HEADER_SIZE 2
+#define PHONGO_BINARY_VECTOR_INT8 0x03
+#define PHONGO_BINARY_VECTOR_FLOAT32 0x27
+#define PHONGO_BINARY_VECTOR_PACKED_BIT 0x10
+
 zend_class_entry* php_phongo_binary_ce;
 
 /* Initialize the object and return whether it was successful. An exception will
- * be thrown on error. */
-static bool php_phongo_binary_init(php_phongo_binary_t* intern, const char* data, size_t data_len, zend_long type) /* {{{ */
+ * be thrown on error. The object holds a reference to the data string, which is
+ * never modified, so it is shared rather than copied. */
+static bool php_phongo_binary_init(php_phongo_binary_t* intern, zend_string* data, zend_long type) /* {{{ */
 {
 	if (type < 0 || type > UINT8_MAX) {
 		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "Expected type to be an unsigned 8-bit integer, %" PHONGO_LONG_FORMAT " given", type);
 		return false;
 	}
 
-	if ((type == BSON_SUBTYPE_UUID_DEPRECATED || type == BSON_SUBTYPE_UUID) && data_len != PHONGO_BINARY_UUID_SIZE) {
-		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "Expected UUID length to be %d bytes, %d given", PHONGO_BINARY_UUID_SIZE, data_len);
+	if ((type == BSON_SUBTYPE_UUID_DEPRECATED || type == BSON_SUBTYPE_UUID) && ZSTR_LEN(data) != PHONGO_BINARY_UUID_SIZE) {
+		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "Expected UUID length to be %d bytes, %d given", PHONGO_BINARY_UUID_SIZE, (int) ZSTR_LEN(data));
 		return false;
 	}
 
-	intern->data     = estrndup(data, data_len);
-	intern->data_len = data_len;
-	intern->type     = (uint8_t) type;
+	if (intern->data) {
+		zend_string_release(intern->data);
+	}
+
+	intern->data = zend_string_copy(data);
+	intern->type = (uint8_t) type;
 
 	return true;
 } /* }}} */
@@ -57,7 +70,7 @@ static bool php_phongo_binary_init_from_hash(php_phongo_binary_t* intern, HashTa
 	if ((data = zend_hash_str_find(props, "data", sizeof("data") - 1)) && Z_TYPE_P(data) == IS_STRING &&
 		(type = zend_hash_str_find(props, "type", sizeof("type") - 1)) && Z_TYPE_P(type) == IS_LONG) {
 
-		return php_phongo_binary_init(intern, Z_STRVAL_P(data), Z_STRLEN_P(data), Z_LVAL_P(type));
+		return php_phongo_binary_init(intern, Z_STR_P(data), Z_LVAL_P(type));
 	}
 
 	phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "%s initialization requires \"data\" string and \"type\" integer fields", ZSTR_VAL(php_phongo_binary_ce->name));
@@ -80,7 +93,7 @@ static HashTable* php_phongo_binary_get_properties_hash(phongo_compat_object_han
 	{
 		zval data, type;
 
-		ZVAL_STRINGL(&data, intern->data, intern->data_len);
+		ZVAL_STR_COPY(&data, intern->data);
 		zend_hash_str_update(props, "data", sizeof("data") - 1, &data);
 
 		ZVAL_LONG(&type, intern->type);
@@ -96,20 +109,19 @@ static PHP_METHOD(Binary, __construct)
 {
 	zend_error_handling  error_handling;
 	php_phongo_binary_t* intern;
-	char*                data;
-	size_t               data_len;
+	zend_string*         data;
 	zend_long            type;
 
 	intern = Z_BINARY_OBJ_P(getThis());
 
 	zend_replace_error_handling(EH_THROW, phongo_exception_from_phongo_domain(PHONGO_ERROR_INVALID_ARGUMENT), &error_handling);
-	if (zend_parse_parameters(ZEND_NUM_ARGS(), "sl", &data, &data_len, &type) == FAILURE) {
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "Sl", &data, &type) == FAILURE) {
 		zend_restore_error_handling(&error_handling);
 		return;
 	}
 	zend_restore_error_handling(&error_handling);
 
-	php_phongo_binary_init(intern, data, data_len, type);
+	php_phongo_binary_init(intern, data, type);
 } /* }}} */
 
 /* {{{ proto MongoDB\BSON\Binary MongoDB\BSON\Binary::__set_state(array $properties)
@@ -152,7 +164,7 @@ static PHP_METHOD(Binary, __toString)
 
 	intern = Z_BINARY_OBJ_P(getThis());
 
-	RETURN_STRINGL(intern->data, intern->data_len);
+	RETURN_STR_COPY(intern->data);
 } /* }}} */
 
 /* {{{ proto string MongoDB\BSON\Binary::getData()
@@ -171,7 +183,7 @@ static PHP_METHOD(Binary, getData)
 	}
 	zend_restore_error_handling(&error_handling);
 
-	RETURN_STRINGL(intern->data, intern->data_len);
+	RETURN_STR_COPY(intern->data);
 } /* }}} */
 
 /* {{{ proto integer MongoDB\BSON\Binary::getType()
@@ -193,6 +205,273 @@ static PHP_METHOD(Binary, getType)
 	RETURN_LONG(intern->type);
 } /* }}} */
 
+/* Packs a list of numbers into the data of a vector with the given element
+ * type. Returns NULL and throws an exception if the list has non-sequential
+ * keys or contains an element that the element type cannot represent. */
+static zend_string* php_phongo_binary_pack_vector(HashTable* ht, zend_long vector_type) /* {{{ */
+{
+	zend_string*   data;
+	unsigned char* out;
+	uint32_t       count = zend_hash_num_elements(ht);
+	size_t         data_len;
+	zend_ulong     num_key;
+	zend_string*   string_key;
+	zval*          value;
+	uint32_t       i = 0;
+
+	switch (vector_type) {
+		case PHONGO_BINARY_VECTOR_INT8:
+			data_len = count;
+			break;
+
+		case PHONGO_BINARY_VECTOR_FLOAT32:
+			data_len = (size_t) count * sizeof(float);
+			break;
+
+		case PHONGO_BINARY_VECTOR_PACKED_BIT:
+			data_len = ((size_t) count + 7) / 8;
+			break;
+
+		default:
+			phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "Expected vector type to be one of the VECTOR_TYPE_* constants, %" PHONGO_LONG_FORMAT " given", vector_type);
+			return NULL;
+	}
+
+	data = zend_string_alloc(PHONGO_BINARY_VECTOR_HEADER_SIZE + data_len, 0);
+	out  = (unsigned char*) ZSTR_VAL(data);
+
+	out[0] = (unsigned char) vector_type;
+	out[1] = vector_type == PHONGO_BINARY_VECTOR_PACKED_BIT ? (unsigned char) (data_len * 8 - count) : 0;
+	out += PHONGO_BINARY_VECTOR_HEADER_SIZE;
+
+	/* Bits are set individually, so the bytes of a packed bit vector must start
+	 * out cleared */
+	if (vector_type == PHONGO_BINARY_VECTOR_PACKED_BIT) {
+		memset(out, 0, data_len);
+	}
+
+	ZEND_HASH_FOREACH_KEY_VAL(ht, num_key, string_key, value)
+	{
+		if (string_key || num_key != i) {
+			phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "Expected vector to be a list, but given array is not");
+			goto failure;
+		}
+
+		ZVAL_DEREF(value);
+
+		switch (vector_type) {
+			case PHONGO_BINARY_VECTOR_INT8:
+				if (Z_TYPE_P(value) != IS_LONG || Z_LVAL_P(value) < INT8_MIN || Z_LVAL_P(value) > INT8_MAX) {
+					phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "Expected vector element %" PRIu32 " to be an integer between %d and %d", i, INT8_MIN, INT8_MAX);
+					goto failure;
+				}
+
+				out[i] = (unsigned char) (int8_t) Z_LVAL_P(value);
+				break;
+
+			case PHONGO_BINARY_VECTOR_FLOAT32: {
+				float    f;
+				uint32_t bits;
+
+				if (Z_TYPE_P(value) == IS_DOUBLE) {
+					f = (float) Z_DVAL_P(value);
+				} else if (Z_TYPE_P(value) == IS_LONG) {
+					f = (float) Z_LVAL_P(value);
+				} else {
+					phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "Expected vector element %" PRIu32 " to be a float or integer, %s given", i, PHONGO_ZVAL_CLASS_OR_TYPE_NAME_P(value));
+					goto failure;
+				}
+
+				memcpy(&bits, &f, sizeof(bits));
+				bits = BSON_UINT32_TO_LE(bits);
+				memcpy(out + (size_t) i * sizeof(bits), &bits, sizeof(bits));
+				break;
+			}
+
+			case PHONGO_BINARY_VECTOR_PACKED_BIT:
+				if (Z_TYPE_P(value) == IS_TRUE || (Z_TYPE_P(value) == IS_LONG && Z_LVAL_P(value) == 1)) {
+					out[i / 8] |= (unsigned char) (0x80 >> (i % 8));
+				} else if (Z_TYPE_P(value) != IS_FALSE && !(Z_TYPE_P(value) == IS_LONG && Z_LVAL_P(value) == 0)) {
+					phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "Expected vector element %" PRIu32 " to be a boolean, 0, or 1", i);
+					goto failure;
+				}
+				break;
+		}
+
+		i++;
+	}
+	ZEND_HASH_FOREACH_END();
+
+	ZSTR_VAL(data)[ZSTR_LEN(data)] = '\0';
+
+	return data;
+
+failure:
+	zend_string_free(data);
+	return NULL;
+} /* }}} */
+
+/* Returns the element type of a vector and the number of elements it contains.
+ * An exception is thrown and false is returned if the object is not a vector or
+ * its data is malformed. */
+static bool php_phongo_binary_get_vector_info(php_phongo_binary_t* intern, uint8_t* vector_type, size_t* count) /* {{{ */
+{
+	const unsigned char* data;
+	size_t               data_len;
+	uint8_t              padding;
+
+	if (intern->type != PHONGO_BINARY_SUBTYPE_VECTOR) {
+		phongo_throw_exception(PHONGO_ERROR_LOGIC, "Expected Binary of type vector (%d), %d given", PHONGO_BINARY_SUBTYPE_VECTOR, intern->type);
+		return false;
+	}
+
+	if (ZSTR_LEN(intern->data) < PHONGO_BINARY_VECTOR_HEADER_SIZE) {
+		goto malformed;
+	}
+
+	data     = (const unsigned char*) ZSTR_VAL(intern->data);
+	data_len = ZSTR_LEN(intern->data) - PHONGO_BINARY_VECTOR_HEADER_SIZE;
+	padding  = data[1];
+
+	switch (data[0]) {
+		case PHONGO_BINARY_VECTOR_INT8:
+			if (padding != 0) {
+				goto malformed;
+			}
+
+			*count = data_len;
+			break;
+
+		case PHONGO_BINARY_VECTOR_FLOAT32:
+			if (padding != 0 || data_len % sizeof(float) != 0) {
+				goto malformed;
+			}
+
+			*count = data_len / sizeof(float);
+			break;
+
+		case PHONGO_BINARY_VECTOR_PACKED_BIT:
+			if (padding > 7 || (data_len == 0 && padding != 0)) {
+				goto malformed;
+			}
+
+			*count = data_len * 8 - padding;
+			break;
+
+		default:
+			phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE, "Unsupported vector type: 0x%02x", data[0]);
+			return false;
+	}
+
+	*vector_type = data[0];
+
+	return true;
+
+malformed:
+	phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE, "Binary vector data is malformed");
+	return false;
+} /* }}} */
+
+/* {{{ proto MongoDB\BSON\Binary MongoDB\BSON\Binary::fromVector(array $vector, int $vectorType)
+   Packs a list of numbers into a Binary of type vector */
+static PHP_METHOD(Binary, fromVector)
+{
+	zend_error_handling  error_handling;
+	php_phongo_binary_t* intern;
+	zval*                vector;
+	zend_long            vector_type;
+	zend_string*         data;
+
+	zend_replace_error_handling(EH_THROW, phongo_exception_from_phongo_domain(PHONGO_ERROR_INVALID_ARGUMENT), &error_handling);
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "al", &vector, &vector_type) == FAILURE) {
+		zend_restore_error_handling(&error_handling);
+		return;
+	}
+	zend_restore_error_handling(&error_handling);
+
+	if (!(data = php_phongo_binary_pack_vector(Z_ARRVAL_P(vector), vector_type))) {
+		/* Exception already thrown */
+		return;
+	}
+
+	object_init_ex(return_value, php_phongo_binary_ce);
+
+	intern       = Z_BINARY_OBJ_P(return_value);
+	intern->data = data;
+	intern->type = PHONGO_BINARY_SUBTYPE_VECTOR;
+} /* }}} */
+
+/* {{{ proto integer MongoDB\BSON\Binary::getVectorType()
+   Returns the element type of a Binary of type vector */
+static PHP_METHOD(Binary, getVectorType)
+{
+	uint8_t vector_type;
+	size_t  count;
+
+	PHONGO_PARSE_PARAMETERS_NONE();
+
+	if (!php_phongo_binary_get_vector_info(Z_BINARY_OBJ_P(getThis()), &vector_type, &count)) {
+		return;
+	}
+
+	RETURN_LONG(vector_type);
+} /* }}} */
+
+/* {{{ proto array MongoDB\BSON\Binary::toArray()
+   Unpacks the elements of a Binary of type vector into a list */
+static PHP_METHOD(Binary, toArray)
+{
+	php_phongo_binary_t* intern;
+	const unsigned char* data;
+	uint8_t              vector_type;
+	size_t               count;
+	size_t               i;
+	zval                 element;
+
+	PHONGO_PARSE_PARAMETERS_NONE();
+
+	intern = Z_BINARY_OBJ_P(getThis());
+
+	if (!php_phongo_binary_get_vector_info(intern, &vector_type, &count)) {
+		return;
+	}
+
+	data = (const unsigned char*) ZSTR_VAL(intern->data) + PHONGO_BINARY_VECTOR_HEADER_SIZE;
+
+	array_init_size(return_value, (uint32_t) count);
+	zend_hash_real_init_packed(Z_ARRVAL_P(return_value));
+
+	/* The element type is dispatched once, so that each loop only converts and
+	 * appends elements to the preallocated list */
+	ZEND_HASH_FILL_PACKED(Z_ARRVAL_P(return_value))
+	{
+		if (vector_type == PHONGO_BINARY_VECTOR_INT8) {
+			for (i = 0; i < count; i++) {
+				ZVAL_LONG(&element, (int8_t) data[i]);
+				ZEND_HASH_FILL_ADD(&element);
+			}
+		} else if (vector_type == PHONGO_BINARY_VECTOR_FLOAT32) {
+			for (i = 0; i < count; i++) {
+				float    f;
+				uint32_t bits;
+
+				memcpy(&bits, data + i * sizeof(bits), sizeof(bits));
+				bits = BSON_UINT32_FROM_LE(bits);
+				memcpy(&f, &bits, sizeof(f));
+
+				ZVAL_DOUBLE(&element, f);
+				ZEND_HASH_FILL_ADD(&element);
+			}
+		} else {
+			for (i = 0; i < count; i++) {
+				ZVAL_LONG(&element, (data[i / 8] >> (7 - i % 8)) & 1);
+				ZEND_HASH_FILL_ADD(&element);
+			}
+		}
+	}
+	ZEND_HASH_FILL_END();
+} /* }}} */
+
 /* {{{ proto array MongoDB\BSON\Binary::jsonSerialize()
 */
 static PHP_METHOD(Binary, jsonSerialize)
@@ -214,7 +493,7 @@ static PHP_METHOD(Binary, jsonSerialize)
 	array_init_size(return_value, 2);
 
 	{
-		zend_string* data = php_base64_encode((unsigned char*) intern->data, intern->data_len);
+		zend_string* data = php_base64_encode((unsigned char*) ZSTR_VAL(intern->data), ZSTR_LEN(intern->data));
 		ADD_ASSOC_STRINGL(return_value, "$binary", ZSTR_VAL(data), ZSTR_LEN(data));
 		zend_string_free(data);
 	}
@@ -243,7 +522,7 @@ static PHP_METHOD(Binary, serialize)
 	zend_restore_error_handling(&error_handling);
 
 	array_init_size(&retval, 2);
-	ADD_ASSOC_STRINGL(&retval, "data", intern->data, intern->data_len);
+	add_assoc_str(&retval, "data", zend_string_copy(intern->data));
 	ADD_ASSOC_LONG_EX(&retval, "type", intern->type);
 
 	PHP_VAR_SERIALIZE_INIT(var_hash);
@@ -327,6 +606,17 @@ ZEND_END_ARG_INFO()
 ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(ai_Binary___toString, 0, 0, IS_STRING, 0)
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(ai_Binary_fromVector, 0, 2, MongoDB\\BSON\\Binary, 0)
+	ZEND_ARG_ARRAY_INFO(0, vector, 0)
+	ZEND_ARG_TYPE_INFO(0, vectorType, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(ai_Binary_getVectorType, 0, 0, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(ai_Binary_toArray, 0, 0, IS_ARRAY, 0)
+ZEND_END_ARG_INFO()
+
 ZEND_BEGIN_ARG_INFO_EX(ai_Binary___unserialize, 0, 0, 1)
 	ZEND_ARG_ARRAY_INFO(0, data, 0)
 ZEND_END_ARG_INFO()
@@ -352,6 +642,9 @@ static zend_function_entry php_phongo_binary_me[] = {
 	PHP_ME(Binary, unserialize, ai_Binary_unserialize, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
 	PHP_ME(Binary, getData, ai_Binary_void, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
 	PHP_ME(Binary, getType, ai_Binary_void, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Binary, fromVector, ai_Binary_fromVector, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC | ZEND_ACC_FINAL)
+	PHP_ME(Binary, getVectorType, ai_Binary_getVectorType, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Binary, toArray, ai_Binary_toArray, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
 	PHP_FE_END
 };
 /* clang-format on */
@@ -367,7 +660,7 @@ static void php_phongo_binary_free_object(zend_object* object) /* {{{ */
 	zend_object_std_dtor(&intern->std);
 
 	if (intern->data) {
-		efree(intern->data);
+		zend_string_release(intern->data);
 	}
 
 	if (intern->properties) {
@@ -400,7 +693,7 @@ static zend_object* php_phongo_binary_clone_object(phongo_compat_object_handler_
 	new_intern = Z_OBJ_BINARY(new_object);
 	zend_objects_clone_members(&new_intern->std, &intern->std);
 
-	php_phongo_binary_init(new_intern, intern->data, intern->data_len, intern->type);
+	php_phongo_binary_init(new_intern, intern->data, intern->type);
 
 	return new_object;
 } /* }}} */
@@ -416,15 +709,15 @@ static int php_phongo_binary_compare_objects(zval* o1, zval* o2) /* {{{ */
 
 	/* MongoDB compares binary types first by the data length, then by the type
 	 * byte, and finally by the binary data itself. */
-	if (intern1->data_len != intern2->data_len) {
-		return intern1->data_len < intern2->data_len ? -1 : 1;
+	if (ZSTR_LEN(intern1->data) != ZSTR_LEN(intern2->data)) {
+		return ZSTR_LEN(intern1->data) < ZSTR_LEN(intern2->data) ? -1 : 1;
 	}
 
 	if (intern1->type != intern2->type) {
 		return intern1->type < intern2->type ? -1 : 1;
 	}
 
-	return zend_binary_strcmp(intern1->data, intern1->data_len, intern2->data, intern2->data_len);
+	return zend_binary_strcmp(ZSTR_VAL(intern1->data), ZSTR_LEN(intern1->data), ZSTR_VAL(intern2->data), ZSTR_LEN(intern2->data));
 } /* }}} */
 
 static HashTable* php_phongo_binary_get_debug_info(phongo_compat_object_handler_type* object, int* is_temp) /* {{{ */
@@ -473,5 +766,10 @@ void php_phongo_binary_init_ce(INIT_FUNC_ARGS) /* {{{ */
 	zend_declare_class_constant_long(php_phongo_binary_ce, ZEND_STRL("TYPE_MD5"), BSON_SUBTYPE_MD5);
 	zend_declare_class_constant_long(php_phongo_binary_ce, ZEND_STRL("TYPE_ENCRYPTED"), BSON_SUBTYPE_ENCRYPTED);
 	zend_declare_class_constant_long(php_phongo_binary_ce, ZEND_STRL("TYPE_COLUMN"), BSON_SUBTYPE_COLUMN);
+	zend_declare_class_constant_long(php_phongo_binary_ce, ZEND_STRL("TYPE_VECTOR"), PHONGO_BINARY_SUBTYPE_VECTOR);
 	zend_declare_class_constant_long(php_phongo_binary_ce, ZEND_STRL("TYPE_USER_DEFINED"), BSON_SUBTYPE_USER);
+
+	zend_declare_class_constant_long(php_phongo_binary_ce, ZEND_STRL("VECTOR_TYPE_INT8"), PHONGO_BINARY_VECTOR_INT8);
+	zend_declare_class_constant_long(php_phongo_binary_ce, ZEND_STRL("VECTOR_TYPE_FLOAT32"), PHONGO_BINARY_VECTOR_FLOAT32);
+	zend_declare_class_constant_long(php_phongo_binary_ce, ZEND_STRL("VECTOR_TYPE_PACKED_BIT"), PHONGO_BINARY_VECTOR_PACKED_BIT);
 } /* }}} */
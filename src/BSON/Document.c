@@ -0,0 +1,395 @@
+/*
+ * Copyright 2022-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bson/bson.h"
+
+#include <php.h>
+#include <ext/standard/base64.h>
+#include <Zend/zend_interfaces.h>
+
+#include "php_phongo.h"
+#include "phongo_bson.h"
+#include "phongo_bson_encode.h"
+#include "phongo_error.h"
+
+#include "BSON/Document.h"
+#include "BSON/Iterator.h"
+
+zend_class_entry* php_phongo_document_ce;
+
+/* Creates a Document object for the given BSON document. The BSON data is
+ * copied, so the caller retains ownership of the bson_t. */
+void phongo_document_new(zval* object, const bson_t* bson) /* {{{ */
+{
+	php_phongo_document_t* intern;
+
+	object_init_ex(object, php_phongo_document_ce);
+
+	intern       = Z_DOCUMENT_OBJ_P(object);
+	intern->bson = bson_copy(bson);
+} /* }}} */
+
+/* Creates a Document object that takes ownership of the given bson_t. */
+static void php_phongo_document_new_from_bson(zval* object, bson_t* bson) /* {{{ */
+{
+	php_phongo_document_t* intern;
+
+	object_init_ex(object, php_phongo_document_ce);
+
+	intern       = Z_DOCUMENT_OBJ_P(object);
+	intern->bson = bson;
+} /* }}} */
+
+static HashTable* php_phongo_document_get_properties_hash(phongo_compat_object_handler_type* object, bool is_temp) /* {{{ */
+{
+	php_phongo_document_t* intern;
+	HashTable*             props;
+
+	intern = Z_OBJ_DOCUMENT(PHONGO_COMPAT_GET_OBJ(object));
+
+	PHONGO_GET_PROPERTY_HASH_INIT_PROPS(is_temp, intern, props, 1);
+
+	if (!intern->bson) {
+		return props;
+	}
+
+	{
+		zval data;
+
+		ZVAL_STR(&data, php_base64_encode(bson_get_data(intern->bson), intern->bson->len));
+		zend_hash_str_update(props, "data", sizeof("data") - 1, &data);
+	}
+
+	return props;
+} /* }}} */
+
+/* {{{ proto MongoDB\BSON\Document MongoDB\BSON\Document::fromBSON(string $bson)
+   Creates a Document from a BSON string. The document is validated but its
+   fields are not decoded until they are accessed. */
+static PHP_METHOD(Document, fromBSON)
+{
+	zend_error_handling error_handling;
+	char*               data;
+	size_t              data_len;
+	bson_t*             bson;
+	size_t              error_offset;
+
+	zend_replace_error_handling(EH_THROW, phongo_exception_from_phongo_domain(PHONGO_ERROR_INVALID_ARGUMENT), &error_handling);
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "s", &data, &data_len) == FAILURE) {
+		zend_restore_error_handling(&error_handling);
+		return;
+	}
+	zend_restore_error_handling(&error_handling);
+
+	if (!(bson = bson_new_from_data((const uint8_t*) data, data_len))) {
+		phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE, "Could not read document from BSON reader");
+		return;
+	}
+
+	if (!bson_validate(bson, BSON_VALIDATE_NONE, &error_offset)) {
+		phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE, "Detected corrupt BSON data at offset %zu", error_offset);
+		bson_destroy(bson);
+		return;
+	}
+
+	php_phongo_document_new_from_bson(return_value, bson);
+} /* }}} */
+
+/* {{{ proto MongoDB\BSON\Document MongoDB\BSON\Document::fromJSON(string $json)
+   Creates a Document from a JSON string */
+static PHP_METHOD(Document, fromJSON)
+{
+	zend_error_handling error_handling;
+	char*               json;
+	size_t              json_len;
+	bson_t*             bson;
+	bson_error_t        error = { 0 };
+
+	zend_replace_error_handling(EH_THROW, phongo_exception_from_phongo_domain(PHONGO_ERROR_INVALID_ARGUMENT), &error_handling);
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "s", &json, &json_len) == FAILURE) {
+		zend_restore_error_handling(&error_handling);
+		return;
+	}
+	zend_restore_error_handling(&error_handling);
+
+	if (!(bson = bson_new_from_json((const uint8_t*) json, json_len, &error))) {
+		phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE, "%s", error.domain == BSON_ERROR_JSON ? error.message : "Error parsing JSON");
+		return;
+	}
+
+	php_phongo_document_new_from_bson(return_value, bson);
+} /* }}} */
+
+/* {{{ proto MongoDB\BSON\Document MongoDB\BSON\Document::fromPHP(array|object $value)
+   Creates a Document from a PHP value */
+static PHP_METHOD(Document, fromPHP)
+{
+	zend_error_handling error_handling;
+	zval*               data;
+	bson_t*             bson;
+
+	zend_replace_error_handling(EH_THROW, phongo_exception_from_phongo_domain(PHONGO_ERROR_INVALID_ARGUMENT), &error_handling);
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "A", &data) == FAILURE) {
+		zend_restore_error_handling(&error_handling);
+		return;
+	}
+	zend_restore_error_handling(&error_handling);
+
+	bson = bson_new();
+	php_phongo_zval_to_bson(data, PHONGO_BSON_NONE, bson, NULL);
+
+	if (EG(exception)) {
+		bson_destroy(bson);
+		return;
+	}
+
+	php_phongo_document_new_from_bson(return_value, bson);
+} /* }}} */
+
+/* {{{ proto mixed MongoDB\BSON\Document::get(string $key)
+   Returns the value of a field, decoding only that field */
+static PHP_METHOD(Document, get)
+{
+	zend_error_handling    error_handling;
+	php_phongo_document_t* intern;
+	char*                  key;
+	size_t                 key_len;
+	bson_iter_t            iter;
+
+	intern = Z_DOCUMENT_OBJ_P(getThis());
+
+	zend_replace_error_handling(EH_THROW, phongo_exception_from_phongo_domain(PHONGO_ERROR_INVALID_ARGUMENT), &error_handling);
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "s", &key, &key_len) == FAILURE) {
+		zend_restore_error_handling(&error_handling);
+		return;
+	}
+	zend_restore_error_handling(&error_handling);
+
+	if (!bson_iter_init_find_w_len(&iter, intern->bson, key, key_len)) {
+		phongo_throw_exception(PHONGO_ERROR_RUNTIME, "Could not find key \"%s\" in BSON document", key);
+		return;
+	}
+
+	php_phongo_bson_iter_to_zval(&iter, return_value);
+} /* }}} */
+
+/* {{{ proto MongoDB\BSON\Iterator MongoDB\BSON\Document::getIterator()
+   Returns an iterator over the fields of the document */
+static PHP_METHOD(Document, getIterator)
+{
+	PHONGO_PARSE_PARAMETERS_NONE();
+
+	phongo_iterator_new(return_value, getThis());
+} /* }}} */
+
+/* {{{ proto boolean MongoDB\BSON\Document::has(string $key)
+   Returns whether the document contains a field */
+static PHP_METHOD(Document, has)
+{
+	zend_error_handling    error_handling;
+	php_phongo_document_t* intern;
+	char*                  key;
+	size_t                 key_len;
+	bson_iter_t            iter;
+
+	intern = Z_DOCUMENT_OBJ_P(getThis());
+
+	zend_replace_error_handling(EH_THROW, phongo_exception_from_phongo_domain(PHONGO_ERROR_INVALID_ARGUMENT), &error_handling);
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "s", &key, &key_len) == FAILURE) {
+		zend_restore_error_handling(&error_handling);
+		return;
+	}
+	zend_restore_error_handling(&error_handling);
+
+	RETURN_BOOL(bson_iter_init_find_w_len(&iter, intern->bson, key, key_len));
+} /* }}} */
+
+/* {{{ proto array|object MongoDB\BSON\Document::toPHP([array $typemap = array()])
+   Returns the PHP representation of the document */
+static PHP_METHOD(Document, toPHP)
+{
+	zend_error_handling    error_handling;
+	php_phongo_document_t* intern;
+	zval*                  typemap = NULL;
+	php_phongo_bson_state  state;
+
+	PHONGO_BSON_INIT_STATE(state);
+
+	intern = Z_DOCUMENT_OBJ_P(getThis());
+
+	zend_replace_error_handling(EH_THROW, phongo_exception_from_phongo_domain(PHONGO_ERROR_INVALID_ARGUMENT), &error_handling);
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "|a!", &typemap) == FAILURE) {
+		zend_restore_error_handling(&error_handling);
+		return;
+	}
+	zend_restore_error_handling(&error_handling);
+
+	if (!php_phongo_bson_typemap_to_state(typemap, &state.map)) {
+		return;
+	}
+
+	if (!php_phongo_bson_doc_to_zval_ex(intern->bson, &state)) {
+		zval_ptr_dtor(&state.zchild);
+		php_phongo_bson_typemap_dtor(&state.map);
+		RETURN_NULL();
+	}
+
+	php_phongo_bson_typemap_dtor(&state.map);
+
+	RETURN_ZVAL(&state.zchild, 0, 1);
+} /* }}} */
+
+/* {{{ proto string MongoDB\BSON\Document::__toString()
+   Returns the BSON representation of the document */
+static PHP_METHOD(Document, __toString)
+{
+	php_phongo_document_t* intern;
+
+	PHONGO_PARSE_PARAMETERS_NONE();
+
+	intern = Z_DOCUMENT_OBJ_P(getThis());
+
+	RETURN_STRINGL((const char*) bson_get_data(intern->bson), intern->bson->len);
+} /* }}} */
+
+/* {{{ MongoDB\BSON\Document function entries */
+/* clang-format off */
+ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(ai_Document_fromBSON, 0, 1, MongoDB\\BSON\\Document, 0)
+	ZEND_ARG_TYPE_INFO(0, bson, IS_STRING, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(ai_Document_fromJSON, 0, 1, MongoDB\\BSON\\Document, 0)
+	ZEND_ARG_TYPE_INFO(0, json, IS_STRING, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(ai_Document_fromPHP, 0, 1, MongoDB\\BSON\\Document, 0)
+	ZEND_ARG_INFO(0, value)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(ai_Document_get, 0, 0, 1)
+	ZEND_ARG_TYPE_INFO(0, key, IS_STRING, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(ai_Document_getIterator, 0, 0, MongoDB\\BSON\\Iterator, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(ai_Document_has, 0, 1, _IS_BOOL, 0)
+	ZEND_ARG_TYPE_INFO(0, key, IS_STRING, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(ai_Document_toPHP, 0, 0, 0)
+	ZEND_ARG_ARRAY_INFO(0, typeMap, 1)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(ai_Document___toString, 0, 0, IS_STRING, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(ai_Document_void, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+static zend_function_entry php_phongo_document_me[] = {
+	PHP_ME(Document, fromBSON, ai_Document_fromBSON, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC | ZEND_ACC_FINAL)
+	PHP_ME(Document, fromJSON, ai_Document_fromJSON, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC | ZEND_ACC_FINAL)
+	PHP_ME(Document, fromPHP, ai_Document_fromPHP, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC | ZEND_ACC_FINAL)
+	PHP_ME(Document, get, ai_Document_get, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Document, getIterator, ai_Document_getIterator, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Document, has, ai_Document_has, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Document, toPHP, ai_Document_toPHP, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Document, __toString, ai_Document___toString, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	ZEND_NAMED_ME(__construct, PHP_FN(MongoDB_disabled___construct), ai_Document_void, ZEND_ACC_PRIVATE | ZEND_ACC_FINAL)
+	PHP_FE_END
+};
+/* clang-format on */
+/* }}} */
+
+/* {{{ MongoDB\BSON\Document object handlers */
+static zend_object_handlers php_phongo_handler_document;
+
+static void php_phongo_document_free_object(zend_object* object) /* {{{ */
+{
+	php_phongo_document_t* intern = Z_OBJ_DOCUMENT(object);
+
+	zend_object_std_dtor(&intern->std);
+
+	if (intern->bson) {
+		bson_destroy(intern->bson);
+	}
+
+	if (intern->properties) {
+		zend_hash_destroy(intern->properties);
+		FREE_HASHTABLE(intern->properties);
+	}
+} /* }}} */
+
+static zend_object* php_phongo_document_create_object(zend_class_entry* class_type) /* {{{ */
+{
+	php_phongo_document_t* intern = zend_object_alloc(sizeof(php_phongo_document_t), class_type);
+
+	zend_object_std_init(&intern->std, class_type);
+	object_properties_init(&intern->std, class_type);
+
+	intern->std.handlers = &php_phongo_handler_document;
+
+	return &intern->std;
+} /* }}} */
+
+static zend_object* php_phongo_document_clone_object(phongo_compat_object_handler_type* object) /* {{{ */
+{
+	php_phongo_document_t* intern;
+	php_phongo_document_t* new_intern;
+	zend_object*           new_object;
+
+	intern     = Z_OBJ_DOCUMENT(PHONGO_COMPAT_GET_OBJ(object));
+	new_object = php_phongo_document_create_object(PHONGO_COMPAT_GET_OBJ(object)->ce);
+
+	new_intern = Z_OBJ_DOCUMENT(new_object);
+	zend_objects_clone_members(&new_intern->std, &intern->std);
+
+	new_intern->bson = bson_copy(intern->bson);
+
+	return new_object;
+} /* }}} */
+
+static HashTable* php_phongo_document_get_debug_info(phongo_compat_object_handler_type* object, int* is_temp) /* {{{ */
+{
+	*is_temp = 1;
+	return php_phongo_document_get_properties_hash(object, true);
+} /* }}} */
+/* }}} */
+
+void php_phongo_document_init_ce(INIT_FUNC_ARGS) /* {{{ */
+{
+	zend_class_entry ce;
+
+	INIT_NS_CLASS_ENTRY(ce, "MongoDB\\BSON", "Document", php_phongo_document_me);
+	php_phongo_document_ce                = zend_register_internal_class(&ce);
+	php_phongo_document_ce->create_object = php_phongo_document_create_object;
+	PHONGO_CE_FINAL(php_phongo_document_ce);
+	PHONGO_CE_DISABLE_SERIALIZATION(php_phongo_document_ce);
+
+	zend_class_implements(php_phongo_document_ce, 1, zend_ce_aggregate);
+	zend_class_implements(php_phongo_document_ce, 1, php_phongo_type_ce);
+
+#if PHP_VERSION_ID >= 80000
+	zend_class_implements(php_phongo_document_ce, 1, zend_ce_stringable);
+#endif
+
+	memcpy(&php_phongo_handler_document, phongo_get_std_object_handlers(), sizeof(zend_object_handlers));
+	php_phongo_handler_document.clone_obj      = php_phongo_document_clone_object;
+	php_phongo_handler_document.get_debug_info = php_phongo_document_get_debug_info;
+	php_phongo_handler_document.free_obj       = php_phongo_document_free_object;
+	php_phongo_handler_document.offset         = XtOffsetOf(php_phongo_document_t, std);
+} /* }}} */
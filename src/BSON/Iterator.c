@@ -0,0 +1,247 @@
+/*
+ * Copyright 2022-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bson/bson.h"
+
+#include <php.h>
+#include <Zend/zend_interfaces.h>
+
+#include "php_phongo.h"
+#include "phongo_bson.h"
+#include "phongo_error.h"
+
+#include "BSON/Iterator.h"
+
+zend_class_entry* php_phongo_iterator_ce;
+
+/* Returns the BSON data of the Document or PackedArray being iterated. */
+static const bson_t* php_phongo_iterator_get_bson(php_phongo_iterator_t* intern) /* {{{ */
+{
+	if (intern->is_array) {
+		return Z_PACKEDARRAY_OBJ_P(&intern->bson)->bson;
+	}
+
+	return Z_DOCUMENT_OBJ_P(&intern->bson)->bson;
+} /* }}} */
+
+static void php_phongo_iterator_free_current(php_phongo_iterator_t* intern) /* {{{ */
+{
+	if (!Z_ISUNDEF(intern->current)) {
+		zval_ptr_dtor(&intern->current);
+		ZVAL_UNDEF(&intern->current);
+	}
+} /* }}} */
+
+static void php_phongo_iterator_rewind(php_phongo_iterator_t* intern) /* {{{ */
+{
+	php_phongo_iterator_free_current(intern);
+
+	intern->key   = 0;
+	intern->valid = bson_iter_init(&intern->iter, php_phongo_iterator_get_bson(intern)) && bson_iter_next(&intern->iter);
+} /* }}} */
+
+/* Creates an Iterator for the given Document or PackedArray. The iterator holds
+ * a reference to its subject, whose BSON data is never modified. */
+void phongo_iterator_new(zval* object, zval* subject) /* {{{ */
+{
+	php_phongo_iterator_t* intern;
+
+	object_init_ex(object, php_phongo_iterator_ce);
+
+	intern           = Z_ITERATOR_OBJ_P(object);
+	intern->is_array = instanceof_function(Z_OBJCE_P(subject), php_phongo_packedarray_ce);
+	ZVAL_COPY(&intern->bson, subject);
+
+	php_phongo_iterator_rewind(intern);
+} /* }}} */
+
+/* {{{ proto mixed MongoDB\BSON\Iterator::current()
+   Returns the current value, decoding it on first access */
+static PHP_METHOD(Iterator, current)
+{
+	php_phongo_iterator_t* intern = Z_ITERATOR_OBJ_P(getThis());
+
+	PHONGO_PARSE_PARAMETERS_NONE();
+
+	if (!intern->valid) {
+		phongo_throw_exception(PHONGO_ERROR_LOGIC, "Cannot call current() on an exhausted iterator");
+		return;
+	}
+
+	if (Z_ISUNDEF(intern->current) && !php_phongo_bson_iter_to_zval(&intern->iter, &intern->current)) {
+		/* Exception already thrown */
+		return;
+	}
+
+	RETURN_ZVAL(&intern->current, 1, 0);
+} /* }}} */
+
+/* {{{ proto string|int MongoDB\BSON\Iterator::key()
+   Returns the current field name or array index */
+static PHP_METHOD(Iterator, key)
+{
+	php_phongo_iterator_t* intern = Z_ITERATOR_OBJ_P(getThis());
+
+	PHONGO_PARSE_PARAMETERS_NONE();
+
+	if (!intern->valid) {
+		phongo_throw_exception(PHONGO_ERROR_LOGIC, "Cannot call key() on an exhausted iterator");
+		return;
+	}
+
+	if (intern->is_array) {
+		RETURN_LONG(intern->key);
+	}
+
+	RETURN_STRINGL(bson_iter_key(&intern->iter), bson_iter_key_len(&intern->iter));
+} /* }}} */
+
+/* {{{ proto void MongoDB\BSON\Iterator::next()
+   Advances the iterator to the next element */
+static PHP_METHOD(Iterator, next)
+{
+	php_phongo_iterator_t* intern = Z_ITERATOR_OBJ_P(getThis());
+
+	PHONGO_PARSE_PARAMETERS_NONE();
+
+	php_phongo_iterator_free_current(intern);
+
+	if (intern->valid) {
+		intern->valid = bson_iter_next(&intern->iter);
+		intern->key++;
+	}
+} /* }}} */
+
+/* {{{ proto void MongoDB\BSON\Iterator::rewind()
+   Rewinds the iterator to the first element */
+static PHP_METHOD(Iterator, rewind)
+{
+	PHONGO_PARSE_PARAMETERS_NONE();
+
+	php_phongo_iterator_rewind(Z_ITERATOR_OBJ_P(getThis()));
+} /* }}} */
+
+/* {{{ proto boolean MongoDB\BSON\Iterator::valid()
+   Returns whether the iterator is positioned on an element */
+static PHP_METHOD(Iterator, valid)
+{
+	PHONGO_PARSE_PARAMETERS_NONE();
+
+	RETURN_BOOL(Z_ITERATOR_OBJ_P(getThis())->valid);
+} /* }}} */
+
+/* {{{ MongoDB\BSON\Iterator function entries */
+/* clang-format off */
+ZEND_BEGIN_ARG_WITH_TENTATIVE_RETURN_TYPE_INFO_EX(ai_Iterator_current, 0, 0, IS_MIXED, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_TENTATIVE_RETURN_TYPE_INFO_EX(ai_Iterator_key, 0, 0, IS_MIXED, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_TENTATIVE_RETURN_TYPE_INFO_EX(ai_Iterator_next, 0, 0, IS_VOID, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_TENTATIVE_RETURN_TYPE_INFO_EX(ai_Iterator_rewind, 0, 0, IS_VOID, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_TENTATIVE_RETURN_TYPE_INFO_EX(ai_Iterator_valid, 0, 0, _IS_BOOL, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(ai_Iterator_void, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+static zend_function_entry php_phongo_iterator_me[] = {
+	PHP_ME(Iterator, current, ai_Iterator_current, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Iterator, key, ai_Iterator_key, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Iterator, next, ai_Iterator_next, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Iterator, rewind, ai_Iterator_rewind, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Iterator, valid, ai_Iterator_valid, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	ZEND_NAMED_ME(__construct, PHP_FN(MongoDB_disabled___construct), ai_Iterator_void, ZEND_ACC_PRIVATE | ZEND_ACC_FINAL)
+	PHP_FE_END
+};
+/* clang-format on */
+/* }}} */
+
+/* {{{ MongoDB\BSON\Iterator object handlers */
+static zend_object_handlers php_phongo_handler_iterator;
+
+static void php_phongo_iterator_free_object(zend_object* object) /* {{{ */
+{
+	php_phongo_iterator_t* intern = Z_OBJ_ITERATOR(object);
+
+	zend_object_std_dtor(&intern->std);
+
+	php_phongo_iterator_free_current(intern);
+
+	if (!Z_ISUNDEF(intern->bson)) {
+		zval_ptr_dtor(&intern->bson);
+	}
+
+	if (intern->properties) {
+		zend_hash_destroy(intern->properties);
+		FREE_HASHTABLE(intern->properties);
+	}
+} /* }}} */
+
+static zend_object* php_phongo_iterator_create_object(zend_class_entry* class_type) /* {{{ */
+{
+	php_phongo_iterator_t* intern = zend_object_alloc(sizeof(php_phongo_iterator_t), class_type);
+
+	zend_object_std_init(&intern->std, class_type);
+	object_properties_init(&intern->std, class_type);
+
+	intern->std.handlers = &php_phongo_handler_iterator;
+
+	return &intern->std;
+} /* }}} */
+
+static HashTable* php_phongo_iterator_get_debug_info(phongo_compat_object_handler_type* object, int* is_temp) /* {{{ */
+{
+	php_phongo_iterator_t* intern;
+	HashTable*             props;
+
+	*is_temp = 1;
+	intern   = Z_OBJ_ITERATOR(PHONGO_COMPAT_GET_OBJ(object));
+
+	PHONGO_GET_PROPERTY_HASH_INIT_PROPS(true, intern, props, 1);
+
+	if (!Z_ISUNDEF(intern->bson)) {
+		Z_ADDREF(intern->bson);
+		zend_hash_str_update(props, "bson", sizeof("bson") - 1, &intern->bson);
+	}
+
+	return props;
+} /* }}} */
+/* }}} */
+
+void php_phongo_iterator_init_ce(INIT_FUNC_ARGS) /* {{{ */
+{
+	zend_class_entry ce;
+
+	INIT_NS_CLASS_ENTRY(ce, "MongoDB\\BSON", "Iterator", php_phongo_iterator_me);
+	php_phongo_iterator_ce                = zend_register_internal_class(&ce);
+	php_phongo_iterator_ce->create_object = php_phongo_iterator_create_object;
+	PHONGO_CE_FINAL(php_phongo_iterator_ce);
+	PHONGO_CE_DISABLE_SERIALIZATION(php_phongo_iterator_ce);
+
+	zend_class_implements(php_phongo_iterator_ce, 1, zend_ce_iterator);
+
+	memcpy(&php_phongo_handler_iterator, phongo_get_std_object_handlers(), sizeof(zend_object_handlers));
+	php_phongo_handler_iterator.clone_obj      = NULL;
+	php_phongo_handler_iterator.get_debug_info = php_phongo_iterator_get_debug_info;
+	php_phongo_handler_iterator.free_obj       = php_phongo_iterator_free_object;
+	php_phongo_handler_iterator.offset         = XtOffsetOf(php_phongo_iterator_t, std);
+} /* }}} */
@@ -93,7 +93,7 @@ HashTable* php_phongo_javascript_get_properties_hash(phongo_compat_object_handle
 			php_phongo_bson_state state;
 
 			PHONGO_BSON_INIT_STATE(state);
-			if (!php_phongo_bson_to_zval_ex(bson_get_data(intern->scope), intern->scope->len, &state)) {
+			if (!php_phongo_bson_doc_to_zval_ex(intern->scope, &state)) {
 				zval_ptr_dtor(&state.zchild);
 				goto failure;
 			}
@@ -225,7 +225,7 @@ static PHP_METHOD(Javascript, getScope)
 
 		PHONGO_BSON_INIT_STATE(state);
 
-		if (!php_phongo_bson_to_zval_ex(bson_get_data(intern->scope), intern->scope->len, &state)) {
+		if (!php_phongo_bson_doc_to_zval_ex(intern->scope, &state)) {
 			zval_ptr_dtor(&state.zchild);
 			return;
 		}
@@ -259,7 +259,7 @@ static PHP_METHOD(Javascript, jsonSerialize)
 		php_phongo_bson_state state;
 
 		PHONGO_BSON_INIT_STATE(state);
-		if (!php_phongo_bson_to_zval_ex(bson_get_data(intern->scope), intern->scope->len, &state)) {
+		if (!php_phongo_bson_doc_to_zval_ex(intern->scope, &state)) {
 			zval_ptr_dtor(&state.zchild);
 			return;
 		}
@@ -291,7 +291,7 @@ static PHP_METHOD(Javascript, serialize)
 	zend_restore_error_handling(&error_handling);
 
 	if (intern->scope && intern->scope->len) {
-		if (!php_phongo_bson_to_zval_ex(bson_get_data(intern->scope), intern->scope->len, &state)) {
+		if (!php_phongo_bson_doc_to_zval_ex(intern->scope, &state)) {
 			zval_ptr_dtor(&state.zchild);
 			return;
 		}
@@ -24,8 +24,8 @@
 #include "php_phongo.h"
 #include "phongo_error.h"
 
-#define PHONGO_OID_SIZE sizeof(((php_phongo_objectid_t*) 0)->oid)
-#define PHONGO_OID_LEN (PHONGO_OID_SIZE - 1)
+/* Length of the hex representation of an ObjectId, excluding the terminator */
+#define PHONGO_OID_LEN 24
 
 zend_class_entry* php_phongo_objectid_ce;
 
@@ -33,12 +33,9 @@ zend_class_entry* php_phongo_objectid_ce;
  * successful. */
 static bool php_phongo_objectid_init(php_phongo_objectid_t* intern)
 {
-	bson_oid_t oid;
-
 	intern->initialized = true;
 
-	bson_oid_init(&oid, NULL);
-	bson_oid_to_string(&oid, intern->oid);
+	bson_oid_init(&intern->oid, NULL);
 
 	return true;
 }
@@ -48,10 +45,7 @@ static bool php_phongo_objectid_init(php_phongo_objectid_t* intern)
 static bool php_phongo_objectid_init_from_hex_string(php_phongo_objectid_t* intern, const char* hex, size_t hex_len) /* {{{ */
 {
 	if (bson_oid_is_valid(hex, hex_len)) {
-		bson_oid_t oid;
-
-		bson_oid_init_from_string(&oid, hex);
-		bson_oid_to_string(&oid, intern->oid);
+		bson_oid_init_from_string(&intern->oid, hex);
 		intern->initialized = true;
 
 		return true;
@@ -92,9 +86,11 @@ static HashTable* php_phongo_objectid_get_properties_hash(phongo_compat_object_h
 	}
 
 	{
+		char hex[PHONGO_OID_LEN + 1];
 		zval zv;
 
-		ZVAL_STRING(&zv, intern->oid);
+		bson_oid_to_string(&intern->oid, hex);
+		ZVAL_STRINGL(&zv, hex, PHONGO_OID_LEN);
 		zend_hash_str_update(props, "oid", sizeof("oid") - 1, &zv);
 	}
 
@@ -132,7 +128,6 @@ static PHP_METHOD(ObjectId, getTimestamp)
 {
 	zend_error_handling    error_handling;
 	php_phongo_objectid_t* intern;
-	bson_oid_t             tmp_oid;
 
 	intern = Z_OBJECTID_OBJ_P(getThis());
 
@@ -143,8 +138,7 @@ static PHP_METHOD(ObjectId, getTimestamp)
 	}
 	zend_restore_error_handling(&error_handling);
 
-	bson_oid_init_from_string(&tmp_oid, intern->oid);
-	RETVAL_LONG(bson_oid_get_time_t(&tmp_oid));
+	RETVAL_LONG(bson_oid_get_time_t(&intern->oid));
 } /* }}} */
 
 /* {{{ proto MongoDB\BSON\ObjectId MongoDB\BSON\ObjectId::__set_state(array $properties)
@@ -177,6 +171,7 @@ static PHP_METHOD(ObjectId, __toString)
 {
 	zend_error_handling    error_handling;
 	php_phongo_objectid_t* intern;
+	char                   hex[PHONGO_OID_LEN + 1];
 
 	intern = Z_OBJECTID_OBJ_P(getThis());
 
@@ -187,7 +182,8 @@ static PHP_METHOD(ObjectId, __toString)
 	}
 	zend_restore_error_handling(&error_handling);
 
-	RETURN_STRINGL(intern->oid, PHONGO_OID_LEN);
+	bson_oid_to_string(&intern->oid, hex);
+	RETURN_STRINGL(hex, PHONGO_OID_LEN);
 } /* }}} */
 
 /* {{{ proto array MongoDB\BSON\ObjectId::jsonSerialize()
@@ -196,6 +192,7 @@ static PHP_METHOD(ObjectId, jsonSerialize)
 {
 	zend_error_handling    error_handling;
 	php_phongo_objectid_t* intern;
+	char                   hex[PHONGO_OID_LEN + 1];
 
 	zend_replace_error_handling(EH_THROW, phongo_exception_from_phongo_domain(PHONGO_ERROR_INVALID_ARGUMENT), &error_handling);
 	if (zend_parse_parameters_none() == FAILURE) {
@@ -205,9 +202,10 @@ static PHP_METHOD(ObjectId, jsonSerialize)
 	zend_restore_error_handling(&error_handling);
 
 	intern = Z_OBJECTID_OBJ_P(getThis());
+	bson_oid_to_string(&intern->oid, hex);
 
 	array_init_size(return_value, 1);
-	ADD_ASSOC_STRINGL(return_value, "$oid", intern->oid, PHONGO_OID_LEN);
+	ADD_ASSOC_STRINGL(return_value, "$oid", hex, PHONGO_OID_LEN);
 } /* }}} */
 
 /* {{{ proto string MongoDB\BSON\ObjectId::serialize()
@@ -219,6 +217,7 @@ static PHP_METHOD(ObjectId, serialize)
 	zval                   retval;
 	php_serialize_data_t   var_hash;
 	smart_str              buf = { 0 };
+	char                   hex[PHONGO_OID_LEN + 1];
 
 	intern = Z_OBJECTID_OBJ_P(getThis());
 
@@ -229,8 +228,10 @@ static PHP_METHOD(ObjectId, serialize)
 	}
 	zend_restore_error_handling(&error_handling);
 
+	bson_oid_to_string(&intern->oid, hex);
+
 	array_init_size(&retval, 1);
-	ADD_ASSOC_STRINGL(&retval, "oid", intern->oid, PHONGO_OID_LEN);
+	ADD_ASSOC_STRINGL(&retval, "oid", hex, PHONGO_OID_LEN);
 
 	PHP_VAR_SERIALIZE_INIT(var_hash);
 	php_var_serialize(&buf, &retval, &var_hash);
@@ -380,8 +381,7 @@ static zend_object* php_phongo_objectid_clone_object(phongo_compat_object_handle
 	new_intern = Z_OBJ_OBJECTID(new_object);
 	zend_objects_clone_members(&new_intern->std, &intern->std);
 
-	// Use memcpy to copy bson value to avoid converting to string and back
-	memcpy(&new_intern->oid, &intern->oid, PHONGO_OID_SIZE);
+	bson_oid_copy(&intern->oid, &new_intern->oid);
 	new_intern->initialized = true;
 
 	return new_object;
@@ -397,7 +397,7 @@ static int php_phongo_objectid_compare_objects(zval* o1, zval* o2) /* {{{ */
 	intern1 = Z_OBJECTID_OBJ_P(o1);
 	intern2 = Z_OBJECTID_OBJ_P(o2);
 
-	return strcmp(intern1->oid, intern2->oid);
+	return bson_oid_compare(&intern1->oid, &intern2->oid);
 } /* }}} */
 
 static HashTable* php_phongo_objectid_get_debug_info(phongo_compat_object_handler_type* object, int* is_temp) /* {{{ */
@@ -446,7 +446,7 @@ void phongo_objectid_init(zval* return_value, const bson_oid_t* oid) /* {{{ */
 	object_init_ex(return_value, php_phongo_objectid_ce);
 
 	intern = Z_OBJECTID_OBJ_P(return_value);
-	bson_oid_to_string(oid, intern->oid);
+	bson_oid_copy(oid, &intern->oid);
 	intern->initialized = true;
 }
 /* }}} */
@@ -0,0 +1,396 @@
+/*
+ * Copyright 2022-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bson/bson.h"
+
+#include <php.h>
+#include <ext/standard/base64.h>
+#include <Zend/zend_interfaces.h>
+
+#include "php_phongo.h"
+#include "phongo_bson.h"
+#include "phongo_bson_encode.h"
+#include "phongo_error.h"
+
+#include "BSON/PackedArray.h"
+#include "BSON/Iterator.h"
+
+zend_class_entry* php_phongo_packedarray_ce;
+
+/* Creates a PackedArray object for the given BSON array. The BSON data is
+ * copied, so the caller retains ownership of the bson_t. */
+void phongo_packedarray_new(zval* object, const bson_t* bson) /* {{{ */
+{
+	php_phongo_packedarray_t* intern;
+
+	object_init_ex(object, php_phongo_packedarray_ce);
+
+	intern       = Z_PACKEDARRAY_OBJ_P(object);
+	intern->bson = bson_copy(bson);
+} /* }}} */
+
+/* Creates a PackedArray object that takes ownership of the given bson_t. */
+static void php_phongo_packedarray_new_from_bson(zval* object, bson_t* bson) /* {{{ */
+{
+	php_phongo_packedarray_t* intern;
+
+	object_init_ex(object, php_phongo_packedarray_ce);
+
+	intern       = Z_PACKEDARRAY_OBJ_P(object);
+	intern->bson = bson;
+} /* }}} */
+
+/* Returns whether the array's keys are sequential integers starting at zero. */
+static bool php_phongo_packedarray_is_list(HashTable* ht) /* {{{ */
+{
+	zend_string* string_key;
+	zend_ulong   num_key;
+	zend_ulong   expected = 0;
+
+	ZEND_HASH_FOREACH_KEY(ht, num_key, string_key)
+	{
+		if (string_key || num_key != expected++) {
+			return false;
+		}
+	}
+	ZEND_HASH_FOREACH_END();
+
+	return true;
+} /* }}} */
+
+/* Positions the iterator on the element at the given index and returns whether
+ * it was found. */
+static bool php_phongo_packedarray_find(php_phongo_packedarray_t* intern, zend_long index, bson_iter_t* iter) /* {{{ */
+{
+	char        buf[16];
+	const char* key;
+	size_t      key_len;
+
+	if (index < 0 || (zend_ulong) index > UINT32_MAX) {
+		return false;
+	}
+
+	key_len = bson_uint32_to_string((uint32_t) index, &key, buf, sizeof(buf));
+
+	return bson_iter_init_find_w_len(iter, intern->bson, key, (int) key_len);
+} /* }}} */
+
+static HashTable* php_phongo_packedarray_get_properties_hash(phongo_compat_object_handler_type* object, bool is_temp) /* {{{ */
+{
+	php_phongo_packedarray_t* intern;
+	HashTable*                props;
+
+	intern = Z_OBJ_PACKEDARRAY(PHONGO_COMPAT_GET_OBJ(object));
+
+	PHONGO_GET_PROPERTY_HASH_INIT_PROPS(is_temp, intern, props, 1);
+
+	if (!intern->bson) {
+		return props;
+	}
+
+	{
+		zval data;
+
+		ZVAL_STR(&data, php_base64_encode(bson_get_data(intern->bson), intern->bson->len));
+		zend_hash_str_update(props, "data", sizeof("data") - 1, &data);
+	}
+
+	return props;
+} /* }}} */
+
+/* {{{ proto MongoDB\BSON\PackedArray MongoDB\BSON\PackedArray::fromPHP(array $value)
+   Creates a PackedArray from a PHP list */
+static PHP_METHOD(PackedArray, fromPHP)
+{
+	zend_error_handling error_handling;
+	zval*               data;
+	bson_t*             bson;
+
+	zend_replace_error_handling(EH_THROW, phongo_exception_from_phongo_domain(PHONGO_ERROR_INVALID_ARGUMENT), &error_handling);
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "a", &data) == FAILURE) {
+		zend_restore_error_handling(&error_handling);
+		return;
+	}
+	zend_restore_error_handling(&error_handling);
+
+	if (!php_phongo_packedarray_is_list(Z_ARRVAL_P(data))) {
+		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "Expected value to be a list, but given array is not");
+		return;
+	}
+
+	bson = bson_new();
+	php_phongo_zval_to_bson(data, PHONGO_BSON_NONE, bson, NULL);
+
+	if (EG(exception)) {
+		bson_destroy(bson);
+		return;
+	}
+
+	php_phongo_packedarray_new_from_bson(return_value, bson);
+} /* }}} */
+
+/* {{{ proto mixed MongoDB\BSON\PackedArray::get(int $index)
+   Returns the value of an element, decoding only that element */
+static PHP_METHOD(PackedArray, get)
+{
+	zend_error_handling       error_handling;
+	php_phongo_packedarray_t* intern;
+	zend_long                 index;
+	bson_iter_t               iter;
+
+	intern = Z_PACKEDARRAY_OBJ_P(getThis());
+
+	zend_replace_error_handling(EH_THROW, phongo_exception_from_phongo_domain(PHONGO_ERROR_INVALID_ARGUMENT), &error_handling);
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "l", &index) == FAILURE) {
+		zend_restore_error_handling(&error_handling);
+		return;
+	}
+	zend_restore_error_handling(&error_handling);
+
+	if (!php_phongo_packedarray_find(intern, index, &iter)) {
+		phongo_throw_exception(PHONGO_ERROR_RUNTIME, "Could not find index %" PHONGO_LONG_FORMAT " in BSON array", index);
+		return;
+	}
+
+	php_phongo_bson_iter_to_zval(&iter, return_value);
+} /* }}} */
+
+/* {{{ proto MongoDB\BSON\Iterator MongoDB\BSON\PackedArray::getIterator()
+   Returns an iterator over the elements of the array */
+static PHP_METHOD(PackedArray, getIterator)
+{
+	PHONGO_PARSE_PARAMETERS_NONE();
+
+	phongo_iterator_new(return_value, getThis());
+} /* }}} */
+
+/* {{{ proto boolean MongoDB\BSON\PackedArray::has(int $index)
+   Returns whether the array contains an element at the given index */
+static PHP_METHOD(PackedArray, has)
+{
+	zend_error_handling       error_handling;
+	php_phongo_packedarray_t* intern;
+	zend_long                 index;
+	bson_iter_t               iter;
+
+	intern = Z_PACKEDARRAY_OBJ_P(getThis());
+
+	zend_replace_error_handling(EH_THROW, phongo_exception_from_phongo_domain(PHONGO_ERROR_INVALID_ARGUMENT), &error_handling);
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "l", &index) == FAILURE) {
+		zend_restore_error_handling(&error_handling);
+		return;
+	}
+	zend_restore_error_handling(&error_handling);
+
+	RETURN_BOOL(php_phongo_packedarray_find(intern, index, &iter));
+} /* }}} */
+
+/* {{{ proto array|object MongoDB\BSON\PackedArray::toPHP([array $typemap = array()])
+   Returns the PHP representation of the array. The "array" type map entry is
+   applied to the array itself. */
+static PHP_METHOD(PackedArray, toPHP)
+{
+	zend_error_handling       error_handling;
+	php_phongo_packedarray_t* intern;
+	zval*                     typemap = NULL;
+	php_phongo_bson_state     state;
+	bool                      as_object;
+
+	PHONGO_BSON_INIT_STATE(state);
+
+	intern = Z_PACKEDARRAY_OBJ_P(getThis());
+
+	zend_replace_error_handling(EH_THROW, phongo_exception_from_phongo_domain(PHONGO_ERROR_INVALID_ARGUMENT), &error_handling);
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "|a!", &typemap) == FAILURE) {
+		zend_restore_error_handling(&error_handling);
+		return;
+	}
+	zend_restore_error_handling(&error_handling);
+
+	if (!php_phongo_bson_typemap_to_state(typemap, &state.map)) {
+		return;
+	}
+
+	/* The array is decoded as a root document whose keys are disregarded. As
+	 * with embedded arrays, a native object is converted from the PHP array
+	 * once all elements have been visited. */
+	as_object = (state.map.array_type == PHONGO_TYPEMAP_NATIVE_OBJECT);
+
+	switch (state.map.array_type) {
+		case PHONGO_TYPEMAP_CLASS:
+		case PHONGO_TYPEMAP_BSON:
+			state.map.root_type = state.map.array_type;
+			state.map.root      = state.map.array;
+			break;
+
+		default:
+			state.map.root_type = PHONGO_TYPEMAP_NATIVE_ARRAY;
+			state.map.root      = NULL;
+	}
+
+	state.is_visiting_array = true;
+
+	if (state.map.root_type == PHONGO_TYPEMAP_BSON) {
+		php_phongo_bson_typemap_dtor(&state.map);
+		RETURN_ZVAL(getThis(), 1, 0);
+	}
+
+	if (!php_phongo_bson_doc_to_zval_ex(intern->bson, &state)) {
+		zval_ptr_dtor(&state.zchild);
+		php_phongo_bson_typemap_dtor(&state.map);
+		RETURN_NULL();
+	}
+
+	php_phongo_bson_typemap_dtor(&state.map);
+
+	if (as_object) {
+		convert_to_object(&state.zchild);
+	}
+
+	RETURN_ZVAL(&state.zchild, 0, 1);
+} /* }}} */
+
+/* {{{ proto string MongoDB\BSON\PackedArray::__toString()
+   Returns the BSON representation of the array */
+static PHP_METHOD(PackedArray, __toString)
+{
+	php_phongo_packedarray_t* intern;
+
+	PHONGO_PARSE_PARAMETERS_NONE();
+
+	intern = Z_PACKEDARRAY_OBJ_P(getThis());
+
+	RETURN_STRINGL((const char*) bson_get_data(intern->bson), intern->bson->len);
+} /* }}} */
+
+/* {{{ MongoDB\BSON\PackedArray function entries */
+/* clang-format off */
+ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(ai_PackedArray_fromPHP, 0, 1, MongoDB\\BSON\\PackedArray, 0)
+	ZEND_ARG_ARRAY_INFO(0, value, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(ai_PackedArray_get, 0, 0, 1)
+	ZEND_ARG_TYPE_INFO(0, index, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(ai_PackedArray_getIterator, 0, 0, MongoDB\\BSON\\Iterator, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(ai_PackedArray_has, 0, 1, _IS_BOOL, 0)
+	ZEND_ARG_TYPE_INFO(0, index, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(ai_PackedArray_toPHP, 0, 0, 0)
+	ZEND_ARG_ARRAY_INFO(0, typeMap, 1)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(ai_PackedArray___toString, 0, 0, IS_STRING, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(ai_PackedArray_void, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+static zend_function_entry php_phongo_packedarray_me[] = {
+	PHP_ME(PackedArray, fromPHP, ai_PackedArray_fromPHP, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC | ZEND_ACC_FINAL)
+	PHP_ME(PackedArray, get, ai_PackedArray_get, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(PackedArray, getIterator, ai_PackedArray_getIterator, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(PackedArray, has, ai_PackedArray_has, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(PackedArray, toPHP, ai_PackedArray_toPHP, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(PackedArray, __toString, ai_PackedArray___toString, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	ZEND_NAMED_ME(__construct, PHP_FN(MongoDB_disabled___construct), ai_PackedArray_void, ZEND_ACC_PRIVATE | ZEND_ACC_FINAL)
+	PHP_FE_END
+};
+/* clang-format on */
+/* }}} */
+
+/* {{{ MongoDB\BSON\PackedArray object handlers */
+static zend_object_handlers php_phongo_handler_packedarray;
+
+static void php_phongo_packedarray_free_object(zend_object* object) /* {{{ */
+{
+	php_phongo_packedarray_t* intern = Z_OBJ_PACKEDARRAY(object);
+
+	zend_object_std_dtor(&intern->std);
+
+	if (intern->bson) {
+		bson_destroy(intern->bson);
+	}
+
+	if (intern->properties) {
+		zend_hash_destroy(intern->properties);
+		FREE_HASHTABLE(intern->properties);
+	}
+} /* }}} */
+
+static zend_object* php_phongo_packedarray_create_object(zend_class_entry* class_type) /* {{{ */
+{
+	php_phongo_packedarray_t* intern = zend_object_alloc(sizeof(php_phongo_packedarray_t), class_type);
+
+	zend_object_std_init(&intern->std, class_type);
+	object_properties_init(&intern->std, class_type);
+
+	intern->std.handlers = &php_phongo_handler_packedarray;
+
+	return &intern->std;
+} /* }}} */
+
+static zend_object* php_phongo_packedarray_clone_object(phongo_compat_object_handler_type* object) /* {{{ */
+{
+	php_phongo_packedarray_t* intern;
+	php_phongo_packedarray_t* new_intern;
+	zend_object*              new_object;
+
+	intern     = Z_OBJ_PACKEDARRAY(PHONGO_COMPAT_GET_OBJ(object));
+	new_object = php_phongo_packedarray_create_object(PHONGO_COMPAT_GET_OBJ(object)->ce);
+
+	new_intern = Z_OBJ_PACKEDARRAY(new_object);
+	zend_objects_clone_members(&new_intern->std, &intern->std);
+
+	new_intern->bson = bson_copy(intern->bson);
+
+	return new_object;
+} /* }}} */
+
+static HashTable* php_phongo_packedarray_get_debug_info(phongo_compat_object_handler_type* object, int* is_temp) /* {{{ */
+{
+	*is_temp = 1;
+	return php_phongo_packedarray_get_properties_hash(object, true);
+} /* }}} */
+/* }}} */
+
+void php_phongo_packedarray_init_ce(INIT_FUNC_ARGS) /* {{{ */
+{
+	zend_class_entry ce;
+
+	INIT_NS_CLASS_ENTRY(ce, "MongoDB\\BSON", "PackedArray", php_phongo_packedarray_me);
+	php_phongo_packedarray_ce                = zend_register_internal_class(&ce);
+	php_phongo_packedarray_ce->create_object = php_phongo_packedarray_create_object;
+	PHONGO_CE_FINAL(php_phongo_packedarray_ce);
+	PHONGO_CE_DISABLE_SERIALIZATION(php_phongo_packedarray_ce);
+
+	zend_class_implements(php_phongo_packedarray_ce, 1, zend_ce_aggregate);
+	zend_class_implements(php_phongo_packedarray_ce, 1, php_phongo_type_ce);
+
+#if PHP_VERSION_ID >= 80000
+	zend_class_implements(php_phongo_packedarray_ce, 1, zend_ce_stringable);
+#endif
+
+	memcpy(&php_phongo_handler_packedarray, phongo_get_std_object_handlers(), sizeof(zend_object_handlers));
+	php_phongo_handler_packedarray.clone_obj      = php_phongo_packedarray_clone_object;
+	php_phongo_handler_packedarray.get_debug_info = php_phongo_packedarray_get_debug_info;
+	php_phongo_handler_packedarray.free_obj       = php_phongo_packedarray_free_object;
+	php_phongo_handler_packedarray.offset         = XtOffsetOf(php_phongo_packedarray_t, std);
+} /* }}} */
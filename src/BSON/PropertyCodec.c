@@ -0,0 +1,46 @@
+/*
+ * Copyright 2022-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <php.h>
+
+#include "php_phongo.h"
+
+zend_class_entry* php_phongo_propertycodec_ce;
+
+/* {{{ MongoDB\BSON\PropertyCodec function entries */
+static zend_function_entry php_phongo_propertycodec_me[] = {
+	PHP_FE_END
+};
+/* }}} */
+
+/* Marker interface for classes whose declared properties map directly to BSON
+ * fields. Such objects are encoded from their property slots, skipping
+ * uninitialized properties and ignoring dynamic properties. Hooked properties
+ * are read through their get hook, and virtual properties are ignored.
+ *
+ * Unlike other objects, whose protected and private properties are never
+ * encoded, properties of every visibility declared by the class are mapped
+ * under their unmangled names, since implementing the interface opts in to
+ * the class' declared properties being its BSON representation. Private
+ * properties declared by a parent class are not visible to the class and are
+ * neither encoded nor hydrated. */
+void php_phongo_propertycodec_init_ce(INIT_FUNC_ARGS) /* {{{ */
+{
+	zend_class_entry ce;
+
+	INIT_NS_CLASS_ENTRY(ce, "MongoDB\\BSON", "PropertyCodec", php_phongo_propertycodec_me);
+	php_phongo_propertycodec_ce = zend_register_internal_interface(&ce);
+} /* }}} */
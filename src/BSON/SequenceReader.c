@@ -0,0 +1,307 @@
+/*
+ * Copyright 2022-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bson/bson.h"
+
+#include <php.h>
+#include <Zend/zend_interfaces.h>
+
+#include "php_phongo.h"
+#include "phongo_bson.h"
+#include "phongo_error.h"
+#include "phongo_util.h"
+
+zend_class_entry* php_phongo_sequencereader_ce;
+
+/* Reads from the stream for libbson's reader. The stream is looked up on each
+ * read, since it may have been closed (e.g. with fclose()) while the reader
+ * still holds a reference to its resource. */
+static ssize_t php_phongo_sequencereader_read(void* handle, void* buf, size_t count) /* {{{ */
+{
+	php_phongo_sequencereader_t* intern = (php_phongo_sequencereader_t*) handle;
+	php_stream*                  stream = php_phongo_stream_from_zval(&intern->stream);
+	ssize_t                      read;
+
+	if (!stream) {
+		return -1;
+	}
+
+	read = (ssize_t) php_stream_read(stream, (char*) buf, count);
+
+	if (read > 0) {
+		intern->bytes_read += read;
+	}
+
+	return read;
+} /* }}} */
+
+/* The stream is owned by its resource, which is released with the object */
+static void php_phongo_sequencereader_destroy(void* handle ARG_UNUSED) /* {{{ */
+{
+} /* }}} */
+
+static void php_phongo_sequencereader_free_current(php_phongo_sequencereader_t* intern) /* {{{ */
+{
+	if (!Z_ISUNDEF(intern->visitor_data.zchild)) {
+		zval_ptr_dtor(&intern->visitor_data.zchild);
+		ZVAL_UNDEF(&intern->visitor_data.zchild);
+	}
+} /* }}} */
+
+/* Reads and decodes the next document into visitor_data.zchild, which is left
+ * undefined at the end of the stream. An exception is thrown if the stream ends
+ * within a document or a document cannot be decoded. Only one document is held
+ * in memory at a time.
+ *
+ * libbson reports the end of the stream even if it ends within a document, so
+ * bytes left over after the last complete document are detected by comparing
+ * the reader's position to the number of bytes read from the stream. */
+static void php_phongo_sequencereader_next(php_phongo_sequencereader_t* intern) /* {{{ */
+{
+	const bson_t* doc;
+	bool          eof = false;
+
+	php_phongo_sequencereader_free_current(intern);
+
+	if (intern->started) {
+		intern->key++;
+	} else {
+		intern->started = true;
+	}
+
+	if (!(doc = bson_reader_read(intern->reader, &eof))) {
+		if (!eof || bson_reader_tell(intern->reader) != intern->bytes_read) {
+			phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE, "Could not read BSON document at offset %" PRId64, (int64_t) bson_reader_tell(intern->reader));
+		}
+
+		return;
+	}
+
+	if (!php_phongo_bson_doc_to_zval_ex(doc, &intern->visitor_data)) {
+		/* Exception already thrown */
+		php_phongo_sequencereader_free_current(intern);
+	}
+} /* }}} */
+
+/* {{{ proto void MongoDB\BSON\SequenceReader::__construct(resource $stream[, array $typemap = null])
+   Constructs a reader for a sequence of BSON documents (e.g. a mongodump file) */
+static PHP_METHOD(SequenceReader, __construct)
+{
+	zend_error_handling          error_handling;
+	php_phongo_sequencereader_t* intern;
+	zval*                        zstream;
+	zval*                        typemap = NULL;
+
+	intern = Z_SEQUENCEREADER_OBJ_P(getThis());
+
+	zend_replace_error_handling(EH_THROW, phongo_exception_from_phongo_domain(PHONGO_ERROR_INVALID_ARGUMENT), &error_handling);
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "r|a!", &zstream, &typemap) == FAILURE) {
+		zend_restore_error_handling(&error_handling);
+		return;
+	}
+	zend_restore_error_handling(&error_handling);
+
+	if (intern->reader) {
+		phongo_throw_exception(PHONGO_ERROR_LOGIC, "%s is already initialized", ZSTR_VAL(php_phongo_sequencereader_ce->name));
+		return;
+	}
+
+	if (!php_phongo_stream_from_zval(zstream)) {
+		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "Expected a stream resource");
+		return;
+	}
+
+	if (!php_phongo_bson_typemap_to_state(typemap, &intern->visitor_data.map)) {
+		return;
+	}
+
+	ZVAL_COPY(&intern->stream, zstream);
+	intern->reader = bson_reader_new_from_handle(intern, php_phongo_sequencereader_read, php_phongo_sequencereader_destroy);
+} /* }}} */
+
+/* {{{ proto array|object|null MongoDB\BSON\SequenceReader::current()
+   Returns the current document */
+static PHP_METHOD(SequenceReader, current)
+{
+	php_phongo_sequencereader_t* intern = Z_SEQUENCEREADER_OBJ_P(getThis());
+
+	PHONGO_PARSE_PARAMETERS_NONE();
+
+	if (Z_ISUNDEF(intern->visitor_data.zchild)) {
+		RETURN_NULL();
+	}
+
+	RETURN_ZVAL(&intern->visitor_data.zchild, 1, 0);
+} /* }}} */
+
+/* {{{ proto int|null MongoDB\BSON\SequenceReader::key()
+   Returns the position of the current document in the sequence */
+static PHP_METHOD(SequenceReader, key)
+{
+	php_phongo_sequencereader_t* intern = Z_SEQUENCEREADER_OBJ_P(getThis());
+
+	PHONGO_PARSE_PARAMETERS_NONE();
+
+	if (Z_ISUNDEF(intern->visitor_data.zchild)) {
+		RETURN_NULL();
+	}
+
+	RETURN_LONG(intern->key);
+} /* }}} */
+
+/* {{{ proto void MongoDB\BSON\SequenceReader::next()
+   Advances to the next document */
+static PHP_METHOD(SequenceReader, next)
+{
+	php_phongo_sequencereader_t* intern = Z_SEQUENCEREADER_OBJ_P(getThis());
+
+	PHONGO_PARSE_PARAMETERS_NONE();
+
+	if (!intern->reader) {
+		phongo_throw_exception(PHONGO_ERROR_LOGIC, "%s is not initialized", ZSTR_VAL(php_phongo_sequencereader_ce->name));
+		return;
+	}
+
+	php_phongo_sequencereader_next(intern);
+} /* }}} */
+
+/* {{{ proto void MongoDB\BSON\SequenceReader::rewind()
+   Reads the first document. Streams are consumed as they are read, so the
+   reader cannot rewind after advancing past the first document. */
+static PHP_METHOD(SequenceReader, rewind)
+{
+	php_phongo_sequencereader_t* intern = Z_SEQUENCEREADER_OBJ_P(getThis());
+
+	PHONGO_PARSE_PARAMETERS_NONE();
+
+	if (!intern->reader) {
+		phongo_throw_exception(PHONGO_ERROR_LOGIC, "%s is not initialized", ZSTR_VAL(php_phongo_sequencereader_ce->name));
+		return;
+	}
+
+	if (intern->key > 0) {
+		phongo_throw_exception(PHONGO_ERROR_LOGIC, "%s cannot rewind after starting iteration", ZSTR_VAL(php_phongo_sequencereader_ce->name));
+		return;
+	}
+
+	if (!intern->started) {
+		php_phongo_sequencereader_next(intern);
+	}
+} /* }}} */
+
+/* {{{ proto boolean MongoDB\BSON\SequenceReader::valid()
+   Returns whether the reader is positioned on a document */
+static PHP_METHOD(SequenceReader, valid)
+{
+	PHONGO_PARSE_PARAMETERS_NONE();
+
+	RETURN_BOOL(!Z_ISUNDEF(Z_SEQUENCEREADER_OBJ_P(getThis())->visitor_data.zchild));
+} /* }}} */
+
+/* {{{ MongoDB\BSON\SequenceReader function entries */
+/* clang-format off */
+ZEND_BEGIN_ARG_INFO_EX(ai_SequenceReader___construct, 0, 0, 1)
+	ZEND_ARG_INFO(0, stream)
+	ZEND_ARG_ARRAY_INFO(0, typemap, 1)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_TENTATIVE_RETURN_TYPE_INFO_EX(ai_SequenceReader_current, 0, 0, IS_MIXED, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_TENTATIVE_RETURN_TYPE_INFO_EX(ai_SequenceReader_key, 0, 0, IS_MIXED, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_TENTATIVE_RETURN_TYPE_INFO_EX(ai_SequenceReader_next, 0, 0, IS_VOID, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_TENTATIVE_RETURN_TYPE_INFO_EX(ai_SequenceReader_rewind, 0, 0, IS_VOID, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_TENTATIVE_RETURN_TYPE_INFO_EX(ai_SequenceReader_valid, 0, 0, _IS_BOOL, 0)
+ZEND_END_ARG_INFO()
+
+static zend_function_entry php_phongo_sequencereader_me[] = {
+	PHP_ME(SequenceReader, __construct, ai_SequenceReader___construct, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(SequenceReader, current, ai_SequenceReader_current, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(SequenceReader, key, ai_SequenceReader_key, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(SequenceReader, next, ai_SequenceReader_next, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(SequenceReader, rewind, ai_SequenceReader_rewind, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(SequenceReader, valid, ai_SequenceReader_valid, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_FE_END
+};
+/* clang-format on */
+/* }}} */
+
+/* {{{ MongoDB\BSON\SequenceReader object handlers */
+static zend_object_handlers php_phongo_handler_sequencereader;
+
+static void php_phongo_sequencereader_free_object(zend_object* object) /* {{{ */
+{
+	php_phongo_sequencereader_t* intern = Z_OBJ_SEQUENCEREADER(object);
+
+	zend_object_std_dtor(&intern->std);
+
+	if (intern->reader) {
+		bson_reader_destroy(intern->reader);
+	}
+
+	if (!Z_ISUNDEF(intern->stream)) {
+		zval_ptr_dtor(&intern->stream);
+	}
+
+	php_phongo_bson_typemap_dtor(&intern->visitor_data.map);
+
+	php_phongo_sequencereader_free_current(intern);
+
+	if (intern->visitor_data.key_cache) {
+		php_phongo_bson_key_cache_free(intern->visitor_data.key_cache);
+	}
+} /* }}} */
+
+static zend_object* php_phongo_sequencereader_create_object(zend_class_entry* class_type) /* {{{ */
+{
+	php_phongo_sequencereader_t* intern = zend_object_alloc(sizeof(php_phongo_sequencereader_t), class_type);
+
+	zend_object_std_init(&intern->std, class_type);
+	object_properties_init(&intern->std, class_type);
+
+	/* Documents in a sequence (e.g. a collection dump) typically share the same
+	 * field names */
+	intern->visitor_data.key_cache = php_phongo_bson_key_cache_new();
+
+	intern->std.handlers = &php_phongo_handler_sequencereader;
+
+	return &intern->std;
+} /* }}} */
+/* }}} */
+
+void php_phongo_sequencereader_init_ce(INIT_FUNC_ARGS) /* {{{ */
+{
+	zend_class_entry ce;
+
+	INIT_NS_CLASS_ENTRY(ce, "MongoDB\\BSON", "SequenceReader", php_phongo_sequencereader_me);
+	php_phongo_sequencereader_ce                = zend_register_internal_class(&ce);
+	php_phongo_sequencereader_ce->create_object = php_phongo_sequencereader_create_object;
+	PHONGO_CE_FINAL(php_phongo_sequencereader_ce);
+	PHONGO_CE_DISABLE_SERIALIZATION(php_phongo_sequencereader_ce);
+
+	zend_class_implements(php_phongo_sequencereader_ce, 1, zend_ce_iterator);
+
+	memcpy(&php_phongo_handler_sequencereader, phongo_get_std_object_handlers(), sizeof(zend_object_handlers));
+	php_phongo_handler_sequencereader.clone_obj = NULL;
+	php_phongo_handler_sequencereader.free_obj  = php_phongo_sequencereader_free_object;
+	php_phongo_handler_sequencereader.offset    = XtOffsetOf(php_phongo_sequencereader_t, std);
+} /* }}} */
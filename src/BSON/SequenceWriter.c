@@ -0,0 +1,338 @@
+/*
+ * Copyright 2022-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bson/bson.h"
+
+#include <php.h>
+#include <Zend/zend_interfaces.h>
+
+#include "php_phongo.h"
+#include "phongo_bson.h"
+#include "phongo_bson_encode.h"
+#include "phongo_error.h"
+#include "phongo_util.h"
+
+#define PHONGO_SEQUENCEWRITER_DEFAULT_BUFFER_SIZE (1024 * 1024)
+
+zend_class_entry* php_phongo_sequencewriter_ce;
+
+/* Starts a new sequence of documents at the beginning of the buffer. The buffer
+ * keeps its size, so documents written after a flush do not reallocate it. */
+static void php_phongo_sequencewriter_reset(php_phongo_sequencewriter_t* intern) /* {{{ */
+{
+	if (intern->writer) {
+		bson_writer_destroy(intern->writer);
+	}
+
+	intern->writer  = bson_writer_new(&intern->buf, &intern->buf_len, 0, php_phongo_bson_erealloc, NULL);
+	intern->written = 0;
+} /* }}} */
+
+/* Throws an exception if a document is being written, since bsonSerialize()
+ * methods may call back into the writer while its buffer is in use. */
+static bool php_phongo_sequencewriter_check_in_write(php_phongo_sequencewriter_t* intern) /* {{{ */
+{
+	if (intern->in_write) {
+		phongo_throw_exception(PHONGO_ERROR_LOGIC, "%s cannot be used while a document is being written", ZSTR_VAL(php_phongo_sequencewriter_ce->name));
+		return false;
+	}
+
+	return true;
+} /* }}} */
+
+/* Writes the buffered documents to the stream. Returns false if the stream was
+ * closed or could not be written to, in which case the documents remain
+ * buffered and further writes are refused until a flush succeeds. The error is
+ * thrown as an exception, or raised as a warning if throw_on_error is false
+ * (e.g. from the destructor). Bytes that were written before a short write are
+ * tracked, so that a later flush resumes after them. */
+static bool php_phongo_sequencewriter_flush(php_phongo_sequencewriter_t* intern, bool throw_on_error) /* {{{ */
+{
+	php_stream* stream;
+	size_t      length;
+	ssize_t     written;
+
+	if (!intern->writer || (length = bson_writer_get_length(intern->writer)) <= intern->written) {
+		return true;
+	}
+
+	if (!(stream = php_phongo_stream_from_zval(&intern->stream))) {
+		intern->flush_failed = true;
+
+		if (throw_on_error) {
+			phongo_throw_exception(PHONGO_ERROR_RUNTIME, "Could not write BSON documents: the stream was closed");
+		} else {
+			php_error_docref(NULL, E_WARNING, "Could not write BSON documents: the stream was closed");
+		}
+
+		return false;
+	}
+
+	written = (ssize_t) php_stream_write(stream, (const char*) intern->buf + intern->written, length - intern->written);
+
+	if (written > 0) {
+		intern->written += (size_t) written;
+	}
+
+	if (intern->written < length) {
+		intern->flush_failed = true;
+
+		if (throw_on_error) {
+			phongo_throw_exception(PHONGO_ERROR_RUNTIME, "Could not write %zu bytes of BSON documents to the stream", length - intern->written);
+		} else {
+			php_error_docref(NULL, E_WARNING, "Could not write %zu bytes of BSON documents to the stream", length - intern->written);
+		}
+
+		return false;
+	}
+
+	intern->flush_failed = false;
+	php_phongo_sequencewriter_reset(intern);
+
+	return true;
+} /* }}} */
+
+/* {{{ proto void MongoDB\BSON\SequenceWriter::__construct(resource $stream[, int $bufferSize = 1048576])
+   Constructs a writer for a sequence of BSON documents (e.g. a mongodump file) */
+static PHP_METHOD(SequenceWriter, __construct)
+{
+	zend_error_handling          error_handling;
+	php_phongo_sequencewriter_t* intern;
+	zval*                        zstream;
+	zend_long                    buffer_size = PHONGO_SEQUENCEWRITER_DEFAULT_BUFFER_SIZE;
+
+	intern = Z_SEQUENCEWRITER_OBJ_P(getThis());
+
+	zend_replace_error_handling(EH_THROW, phongo_exception_from_phongo_domain(PHONGO_ERROR_INVALID_ARGUMENT), &error_handling);
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "r|l", &zstream, &buffer_size) == FAILURE) {
+		zend_restore_error_handling(&error_handling);
+		return;
+	}
+	zend_restore_error_handling(&error_handling);
+
+	if (intern->writer) {
+		phongo_throw_exception(PHONGO_ERROR_LOGIC, "%s is already initialized", ZSTR_VAL(php_phongo_sequencewriter_ce->name));
+		return;
+	}
+
+	if (!php_phongo_stream_from_zval(zstream)) {
+		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "Expected a stream resource");
+		return;
+	}
+
+	if (buffer_size < 1 || buffer_size > INT32_MAX) {
+		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "Expected bufferSize to be a positive 32-bit integer, %" PHONGO_LONG_FORMAT " given", buffer_size);
+		return;
+	}
+
+	ZVAL_COPY(&intern->stream, zstream);
+	intern->buffer_size = (size_t) buffer_size;
+
+	/* The buffer is allocated by the first write and grows with the documents
+	 * written, so bufferSize only bounds its size */
+	php_phongo_sequencewriter_reset(intern);
+} /* }}} */
+
+/* {{{ proto void MongoDB\BSON\SequenceWriter::write(array|object|string $document)
+   Appends a document to the buffer, flushing the buffer once it is full. A
+   MongoDB\BSON\Document (e.g. from a cursor with a "bson" root type map) or a
+   BSON string (e.g. from a "raw" root type map) is copied without decoding. */
+static PHP_METHOD(SequenceWriter, write)
+{
+	php_phongo_sequencewriter_t* intern = Z_SEQUENCEWRITER_OBJ_P(getThis());
+	zval*                        document;
+	const bson_t*                source;
+	bson_t*                      encoded = NULL;
+	bson_t*                      bson;
+	bson_t                       raw;
+
+	PHONGO_PARSE_PARAMETERS_START(1, 1)
+	Z_PARAM_ZVAL(document)
+	PHONGO_PARSE_PARAMETERS_END();
+
+	if (!intern->writer) {
+		phongo_throw_exception(PHONGO_ERROR_LOGIC, "%s is not initialized", ZSTR_VAL(php_phongo_sequencewriter_ce->name));
+		return;
+	}
+
+	if (!php_phongo_sequencewriter_check_in_write(intern)) {
+		return;
+	}
+
+	/* Documents buffered after a failed flush would grow the buffer without
+	 * bound, since the stream is not expected to accept them */
+	if (intern->flush_failed) {
+		phongo_throw_exception(PHONGO_ERROR_LOGIC, "%s cannot write documents until flush() succeeds", ZSTR_VAL(php_phongo_sequencewriter_ce->name));
+		return;
+	}
+
+	if (Z_TYPE_P(document) == IS_STRING) {
+		if (!php_phongo_bson_init_static_from_data(&raw, (const unsigned char*) Z_STRVAL_P(document), Z_STRLEN_P(document)) || raw.len != Z_STRLEN_P(document)) {
+			phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE, "Expected string to contain exactly one BSON document");
+			return;
+		}
+
+		source = &raw;
+	} else if (Z_TYPE_P(document) == IS_OBJECT && instanceof_function(Z_OBJCE_P(document), php_phongo_document_ce)) {
+		source = Z_DOCUMENT_OBJ_P(document)->bson;
+	} else if (Z_TYPE_P(document) == IS_ARRAY || Z_TYPE_P(document) == IS_OBJECT) {
+		/* Documents are encoded into the scratch buffer and then copied, since
+		 * the encoder cannot report fields that libbson fails to append once
+		 * the buffered documents approach the maximum buffer size */
+		encoded = php_phongo_bson_scratch_begin(0);
+
+		intern->in_write = true;
+		php_phongo_zval_to_bson(document, PHONGO_BSON_NONE, encoded, NULL);
+		intern->in_write = false;
+
+		if (EG(exception)) {
+			php_phongo_bson_scratch_end(encoded);
+			return;
+		}
+
+		source = encoded;
+	} else {
+		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "Expected document to be an array, object, or BSON string, %s given", PHONGO_ZVAL_CLASS_OR_TYPE_NAME_P(document));
+		return;
+	}
+
+	if (!bson_writer_begin(intern->writer, &bson)) {
+		phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE, "Could not write BSON document: the buffer cannot grow further");
+		goto cleanup;
+	}
+
+	if (!bson_concat(bson, source)) {
+		bson_writer_rollback(intern->writer);
+		phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE, "Could not write BSON document: the buffer cannot grow further");
+		goto cleanup;
+	}
+
+	bson_writer_end(intern->writer);
+
+	if (bson_writer_get_length(intern->writer) >= intern->buffer_size) {
+		php_phongo_sequencewriter_flush(intern, true);
+	}
+
+cleanup:
+	if (encoded) {
+		php_phongo_bson_scratch_end(encoded);
+	}
+} /* }}} */
+
+/* {{{ proto void MongoDB\BSON\SequenceWriter::flush()
+   Writes all buffered documents to the stream */
+static PHP_METHOD(SequenceWriter, flush)
+{
+	php_phongo_sequencewriter_t* intern = Z_SEQUENCEWRITER_OBJ_P(getThis());
+
+	PHONGO_PARSE_PARAMETERS_NONE();
+
+	if (!php_phongo_sequencewriter_check_in_write(intern)) {
+		return;
+	}
+
+	php_phongo_sequencewriter_flush(intern, true);
+} /* }}} */
+
+/* {{{ MongoDB\BSON\SequenceWriter function entries */
+/* clang-format off */
+ZEND_BEGIN_ARG_INFO_EX(ai_SequenceWriter___construct, 0, 0, 1)
+	ZEND_ARG_INFO(0, stream)
+	ZEND_ARG_TYPE_INFO(0, bufferSize, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(ai_SequenceWriter_write, 0, 1, IS_VOID, 0)
+	ZEND_ARG_INFO(0, document)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(ai_SequenceWriter_flush, 0, 0, IS_VOID, 0)
+ZEND_END_ARG_INFO()
+
+static zend_function_entry php_phongo_sequencewriter_me[] = {
+	PHP_ME(SequenceWriter, __construct, ai_SequenceWriter___construct, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(SequenceWriter, write, ai_SequenceWriter_write, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(SequenceWriter, flush, ai_SequenceWriter_flush, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_FE_END
+};
+/* clang-format on */
+/* }}} */
+
+/* {{{ MongoDB\BSON\SequenceWriter object handlers */
+static zend_object_handlers php_phongo_handler_sequencewriter;
+
+/* Documents still buffered when the writer is destroyed are written to the
+ * stream, unless an exception is already being thrown. Destructors may run
+ * during garbage collection or shutdown, where an exception cannot be caught,
+ * so a failed write only raises a warning. */
+static void php_phongo_sequencewriter_dtor_object(zend_object* object) /* {{{ */
+{
+	php_phongo_sequencewriter_t* intern = Z_OBJ_SEQUENCEWRITER(object);
+
+	zend_objects_destroy_object(object);
+
+	if (!EG(exception)) {
+		php_phongo_sequencewriter_flush(intern, false);
+	}
+} /* }}} */
+
+static void php_phongo_sequencewriter_free_object(zend_object* object) /* {{{ */
+{
+	php_phongo_sequencewriter_t* intern = Z_OBJ_SEQUENCEWRITER(object);
+
+	zend_object_std_dtor(&intern->std);
+
+	if (intern->writer) {
+		bson_writer_destroy(intern->writer);
+	}
+
+	if (intern->buf) {
+		efree(intern->buf);
+	}
+
+	if (!Z_ISUNDEF(intern->stream)) {
+		zval_ptr_dtor(&intern->stream);
+	}
+} /* }}} */
+
+static zend_object* php_phongo_sequencewriter_create_object(zend_class_entry* class_type) /* {{{ */
+{
+	php_phongo_sequencewriter_t* intern = zend_object_alloc(sizeof(php_phongo_sequencewriter_t), class_type);
+
+	zend_object_std_init(&intern->std, class_type);
+	object_properties_init(&intern->std, class_type);
+
+	intern->std.handlers = &php_phongo_handler_sequencewriter;
+
+	return &intern->std;
+} /* }}} */
+/* }}} */
+
+void php_phongo_sequencewriter_init_ce(INIT_FUNC_ARGS) /* {{{ */
+{
+	zend_class_entry ce;
+
+	INIT_NS_CLASS_ENTRY(ce, "MongoDB\\BSON", "SequenceWriter", php_phongo_sequencewriter_me);
+	php_phongo_sequencewriter_ce                = zend_register_internal_class(&ce);
+	php_phongo_sequencewriter_ce->create_object = php_phongo_sequencewriter_create_object;
+	PHONGO_CE_FINAL(php_phongo_sequencewriter_ce);
+	PHONGO_CE_DISABLE_SERIALIZATION(php_phongo_sequencewriter_ce);
+
+	memcpy(&php_phongo_handler_sequencewriter, phongo_get_std_object_handlers(), sizeof(zend_object_handlers));
+	php_phongo_handler_sequencewriter.clone_obj = NULL;
+	php_phongo_handler_sequencewriter.dtor_obj  = php_phongo_sequencewriter_dtor_object;
+	php_phongo_handler_sequencewriter.free_obj  = php_phongo_sequencewriter_free_object;
+	php_phongo_handler_sequencewriter.offset    = XtOffsetOf(php_phongo_sequencewriter_t, std);
+} /* }}} */
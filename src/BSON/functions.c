@@ -43,11 +43,11 @@ PHP_FUNCTION(MongoDB_BSON_fromPHP)
 	}
 	zend_restore_error_handling(&error_handling);
 
-	bson = bson_new();
+	bson = php_phongo_bson_scratch_begin(0);
 	php_phongo_zval_to_bson(data, PHONGO_BSON_NONE, bson, NULL);
 
 	RETVAL_STRINGL((const char*) bson_get_data(bson), bson->len);
-	bson_destroy(bson);
+	php_phongo_bson_scratch_end(bson);
 } /* }}} */
 
 /* {{{ proto array|object MongoDB\BSON\toPHP(string $bson [, array $typemap = array()])
@@ -114,9 +114,7 @@ static void phongo_bson_to_json(INTERNAL_FUNCTION_PARAMETERS, php_phongo_json_mo
 	zend_error_handling error_handling;
 	char*               data;
 	size_t              data_len;
-	const bson_t*       bson;
-	bool                eof = false;
-	bson_reader_t*      reader;
+	bson_t              bson;
 	char*               json = NULL;
 	size_t              json_len;
 
@@ -127,37 +125,30 @@ static void phongo_bson_to_json(INTERNAL_FUNCTION_PARAMETERS, php_phongo_json_mo
 	}
 	zend_restore_error_handling(&error_handling);
 
-	reader = bson_reader_new_from_data((const unsigned char*) data, data_len);
-	bson   = bson_reader_read(reader, NULL);
-
-	if (!bson) {
+	if (!php_phongo_bson_init_static_from_data(&bson, (const unsigned char*) data, data_len)) {
 		phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE, "Could not read document from BSON reader");
-		bson_reader_destroy(reader);
 		return;
 	}
 
 	if (mode == PHONGO_JSON_MODE_LEGACY) {
-		json = bson_as_json(bson, &json_len);
+		json = bson_as_json(&bson, &json_len);
 	} else if (mode == PHONGO_JSON_MODE_CANONICAL) {
-		json = bson_as_canonical_extended_json(bson, &json_len);
+		json = bson_as_canonical_extended_json(&bson, &json_len);
 	} else if (mode == PHONGO_JSON_MODE_RELAXED) {
-		json = bson_as_relaxed_extended_json(bson, &json_len);
+		json = bson_as_relaxed_extended_json(&bson, &json_len);
 	}
 
 	if (!json) {
 		phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE, "Could not convert BSON document to a JSON string");
-		bson_reader_destroy(reader);
 		return;
 	}
 
 	RETVAL_STRINGL(json, json_len);
 	bson_free(json);
 
-	if (bson_reader_read(reader, &eof) || !eof) {
+	if (bson.len != data_len) {
 		phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE, "Reading document did not exhaust input buffer");
 	}
-
-	bson_reader_destroy(reader);
 } /* }}} */
 
 /* {{{ proto string MongoDB\BSON\toJSON(string $bson)
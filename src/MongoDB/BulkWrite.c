@@ -41,7 +41,7 @@ static void php_phongo_bulkwrite_extract_id(bson_t* doc, zval** return_value) /*
 	PHONGO_BSON_INIT_STATE(state);
 	state.map.root_type = PHONGO_TYPEMAP_NATIVE_ARRAY;
 
-	if (!php_phongo_bson_to_zval_ex(bson_get_data(doc), doc->len, &state)) {
+	if (!php_phongo_bson_doc_to_zval_ex(doc, &state)) {
 		goto cleanup;
 	}
 
@@ -55,6 +55,27 @@ cleanup:
 	zval_ptr_dtor(&state.zchild);
 } /* }}} */
 
+/* Records the size of an encoded document. Documents added to the same
+ * BulkWrite tend to have a similar shape, so a running estimate of their size
+ * is reserved up front when encoding the next document. The estimate is a
+ * moving average that gives each new document a weight of 1/4, so that a few
+ * outliers do not keep oversized buffers reserved for the rest of the batch.
+ * It is capped at the size the scratch buffer may retain. */
+static inline void php_phongo_bulkwrite_update_size_hint(php_phongo_bulkwrite_t* intern, const bson_t* doc) /* {{{ */
+{
+	if (intern->size_hint == 0) {
+		intern->size_hint = doc->len;
+	} else if (doc->len > intern->size_hint) {
+		intern->size_hint += (doc->len - intern->size_hint) / 4;
+	} else {
+		intern->size_hint -= (intern->size_hint - doc->len) / 4;
+	}
+
+	if (intern->size_hint > PHONGO_BSON_SCRATCH_MAX_RETAINED_SIZE) {
+		intern->size_hint = PHONGO_BSON_SCRATCH_MAX_RETAINED_SIZE;
+	}
+} /* }}} */
+
 /* Returns whether any top-level field names in the document contain a "$". */
 static inline bool php_phongo_bulkwrite_update_has_operators(bson_t* bupdate) /* {{{ */
 {
@@ -331,12 +352,13 @@ static PHP_METHOD(BulkWrite, __construct)
 		ordered = php_array_fetchc_bool(options, "ordered");
 	}
 
-	intern->bulk     = mongoc_bulk_operation_new(ordered);
-	intern->ordered  = ordered;
-	intern->bypass   = PHONGO_BULKWRITE_BYPASS_UNSET;
-	intern->let      = NULL;
-	intern->num_ops  = 0;
-	intern->executed = false;
+	intern->bulk      = mongoc_bulk_operation_new(ordered);
+	intern->ordered   = ordered;
+	intern->bypass    = PHONGO_BULKWRITE_BYPASS_UNSET;
+	intern->let       = NULL;
+	intern->num_ops   = 0;
+	intern->size_hint = 0;
+	intern->executed  = false;
 
 	if (options && php_array_existsc(options, "bypassDocumentValidation")) {
 		zend_bool bypass = php_array_fetchc_bool(options, "bypassDocumentValidation");
@@ -384,7 +406,8 @@ static PHP_METHOD(BulkWrite, insert)
 	zend_error_handling     error_handling;
 	php_phongo_bulkwrite_t* intern;
 	zval*                   zdocument;
-	bson_t                  bdocument = BSON_INITIALIZER, boptions = BSON_INITIALIZER;
+	bson_t*                 bdocument;
+	bson_t                  boptions   = BSON_INITIALIZER;
 	bson_t*                 bson_out   = NULL;
 	int                     bson_flags = PHONGO_BSON_ADD_ID;
 	bson_error_t            error      = { 0 };
@@ -400,13 +423,18 @@ static PHP_METHOD(BulkWrite, insert)
 
 	bson_flags |= PHONGO_BSON_RETURN_ID;
 
-	php_phongo_zval_to_bson(zdocument, bson_flags, &bdocument, &bson_out);
+	/* libmongoc copies the document into the bulk operation, so it can be
+	 * encoded into the request's scratch buffer. */
+	bdocument = php_phongo_bson_scratch_begin(intern->size_hint);
+	php_phongo_zval_to_bson(zdocument, bson_flags, bdocument, &bson_out);
 
 	if (EG(exception)) {
 		goto cleanup;
 	}
 
-	if (!mongoc_bulk_operation_insert_with_opts(intern->bulk, &bdocument, &boptions, &error)) {
+	php_phongo_bulkwrite_update_size_hint(intern, bdocument);
+
+	if (!mongoc_bulk_operation_insert_with_opts(intern->bulk, bdocument, &boptions, &error)) {
 		phongo_throw_exception_from_bson_error_t(&error);
 		goto cleanup;
 	}
@@ -421,7 +449,7 @@ static PHP_METHOD(BulkWrite, insert)
 	php_phongo_bulkwrite_extract_id(bson_out, &return_value);
 
 cleanup:
-	bson_destroy(&bdocument);
+	php_phongo_bson_scratch_end(bdocument);
 	bson_destroy(&boptions);
 	bson_clear(&bson_out);
 } /* }}} */
@@ -433,7 +461,8 @@ static PHP_METHOD(BulkWrite, update)
 	zend_error_handling     error_handling;
 	php_phongo_bulkwrite_t* intern;
 	zval *                  zquery, *zupdate, *zoptions = NULL;
-	bson_t                  bquery = BSON_INITIALIZER, bupdate = BSON_INITIALIZER, boptions = BSON_INITIALIZER;
+	bson_t                  bquery = BSON_INITIALIZER, boptions = BSON_INITIALIZER;
+	bson_t*                 bupdate = NULL;
 	bson_error_t            error = { 0 };
 
 	intern = Z_BULKWRITE_OBJ_P(getThis());
@@ -451,24 +480,29 @@ static PHP_METHOD(BulkWrite, update)
 		goto cleanup;
 	}
 
-	php_phongo_zval_to_bson(zupdate, PHONGO_BSON_NONE, &bupdate, NULL);
+	/* Replacement documents may be as large as inserted documents, so they are
+	 * encoded into the scratch buffer as well. */
+	bupdate = php_phongo_bson_scratch_begin(intern->size_hint);
+	php_phongo_zval_to_bson(zupdate, PHONGO_BSON_NONE, bupdate, NULL);
 
 	if (EG(exception)) {
 		goto cleanup;
 	}
 
+	php_phongo_bulkwrite_update_size_hint(intern, bupdate);
+
 	if (!php_phongo_bulkwrite_update_apply_options(&boptions, zoptions)) {
 		goto cleanup;
 	}
 
-	if (php_phongo_bulkwrite_update_has_operators(&bupdate) || php_phongo_bulkwrite_update_is_pipeline(&bupdate)) {
+	if (php_phongo_bulkwrite_update_has_operators(bupdate) || php_phongo_bulkwrite_update_is_pipeline(bupdate)) {
 		if (zoptions && php_array_fetchc_bool(zoptions, "multi")) {
-			if (!mongoc_bulk_operation_update_many_with_opts(intern->bulk, &bquery, &bupdate, &boptions, &error)) {
+			if (!mongoc_bulk_operation_update_many_with_opts(intern->bulk, &bquery, bupdate, &boptions, &error)) {
 				phongo_throw_exception_from_bson_error_t(&error);
 				goto cleanup;
 			}
 		} else {
-			if (!mongoc_bulk_operation_update_one_with_opts(intern->bulk, &bquery, &bupdate, &boptions, &error)) {
+			if (!mongoc_bulk_operation_update_one_with_opts(intern->bulk, &bquery, bupdate, &boptions, &error)) {
 				phongo_throw_exception_from_bson_error_t(&error);
 				goto cleanup;
 			}
@@ -479,7 +513,7 @@ static PHP_METHOD(BulkWrite, update)
 			goto cleanup;
 		}
 
-		if (!mongoc_bulk_operation_replace_one_with_opts(intern->bulk, &bquery, &bupdate, &boptions, &error)) {
+		if (!mongoc_bulk_operation_replace_one_with_opts(intern->bulk, &bquery, bupdate, &boptions, &error)) {
 			phongo_throw_exception_from_bson_error_t(&error);
 			goto cleanup;
 		}
@@ -489,7 +523,7 @@ static PHP_METHOD(BulkWrite, update)
 
 cleanup:
 	bson_destroy(&bquery);
-	bson_destroy(&bupdate);
+	php_phongo_bson_scratch_end(bupdate);
 	bson_destroy(&boptions);
 } /* }}} */
 
@@ -15,13 +15,13 @@
  */
 
 #include <php.h>
-#include <ext/spl/spl_iterators.h>
 #include <Zend/zend_interfaces.h>
 
 #include "php_phongo.h"
 #include "phongo_bson.h"
 #include "phongo_client.h"
 #include "phongo_error.h"
+#include "phongo_probes.h"
 
 #include "MongoDB/Cursor.h"
 #include "MongoDB/Server.h"
@@ -52,6 +52,83 @@ static void php_phongo_cursor_free_current(php_phongo_cursor_t* cursor) /* {{{ *
 	}
 } /* }}} */
 
+/* Decodes the cursor's current document into visitor_data.zchild, which is
+ * left undefined if there is no current document or it cannot be decoded. */
+static void php_phongo_cursor_decode_current(php_phongo_cursor_t* cursor, const bson_t* doc) /* {{{ */
+{
+	if (doc && !php_phongo_bson_doc_to_zval_ex(doc, &cursor->visitor_data)) {
+		/* Free invalid result, but don't return as we want to free the
+		 * session if the cursor is exhausted. */
+		php_phongo_cursor_free_current(cursor);
+	}
+} /* }}} */
+
+/* Advances the cursor to its next document. An exception is thrown if the
+ * cursor encounters an error. */
+static void php_phongo_cursor_next(php_phongo_cursor_t* cursor) /* {{{ */
+{
+	const bson_t* doc = NULL;
+	bool          has_document;
+
+	php_phongo_cursor_free_current(cursor);
+
+	/* If the cursor has already advanced, increment its position. Otherwise,
+	 * the first call to mongoc_cursor_next() will be made below and we should
+	 * leave its position at zero. */
+	if (cursor->advanced) {
+		cursor->current++;
+	} else {
+		cursor->advanced = true;
+	}
+
+	if (PHONGO_PROBE_ENABLED(cursor__next__start)) {
+		PHONGO_PROBE1(cursor__next__start, mongoc_cursor_get_id(cursor->cursor));
+	}
+
+	has_document = mongoc_cursor_next(cursor->cursor, &doc);
+	PHONGO_PROBE1(cursor__next__done, has_document);
+
+	if (has_document) {
+		php_phongo_cursor_decode_current(cursor, doc);
+	} else {
+		bson_error_t error = { 0 };
+
+		if (mongoc_cursor_error_document(cursor->cursor, &error, &doc)) {
+			/* Intentionally not destroying the cursor as it will happen
+			 * naturally now that there are no more results */
+			phongo_throw_exception_from_bson_error_t_and_reply(&error, doc);
+		}
+	}
+
+	php_phongo_cursor_free_session_if_exhausted(cursor);
+} /* }}} */
+
+/* Positions the cursor on its first document. Returns false and throws an
+ * exception if the cursor encounters an error or iteration already started. */
+static bool php_phongo_cursor_rewind(php_phongo_cursor_t* cursor) /* {{{ */
+{
+	/* If the cursor was never advanced (e.g. command cursor), do so now */
+	if (!cursor->advanced) {
+		cursor->advanced = true;
+
+		if (!phongo_cursor_advance_and_check_for_error(cursor->cursor)) {
+			/* Exception should already have been thrown */
+			return false;
+		}
+	}
+
+	if (cursor->current > 0) {
+		phongo_throw_exception(PHONGO_ERROR_LOGIC, "Cursors cannot rewind after starting iteration");
+		return false;
+	}
+
+	php_phongo_cursor_free_current(cursor);
+	php_phongo_cursor_decode_current(cursor, mongoc_cursor_current(cursor->cursor));
+	php_phongo_cursor_free_session_if_exhausted(cursor);
+
+	return true;
+} /* }}} */
+
 /* {{{ proto void MongoDB\Driver\Cursor::setTypeMap(array $typemap)
    Sets a type map to use for BSON unserialization */
 static PHP_METHOD(Cursor, setTypeMap)
@@ -86,6 +163,8 @@ static PHP_METHOD(Cursor, setTypeMap)
 
 	php_phongo_bson_typemap_dtor(&intern->visitor_data.map);
 
+	/* The key cache is independent of the type map and remains valid */
+	state.key_cache      = intern->visitor_data.key_cache;
 	intern->visitor_data = state;
 
 	/* If the cursor has a current element, we just freed it and should restore
@@ -93,31 +172,12 @@ static PHP_METHOD(Cursor, setTypeMap)
 	if (restore_current_element && mongoc_cursor_current(intern->cursor)) {
 		const bson_t* doc = mongoc_cursor_current(intern->cursor);
 
-		if (!php_phongo_bson_to_zval_ex(bson_get_data(doc), doc->len, &intern->visitor_data)) {
+		if (!php_phongo_bson_doc_to_zval_ex(doc, &intern->visitor_data)) {
 			php_phongo_cursor_free_current(intern);
 		}
 	}
 } /* }}} */
 
-static int php_phongo_cursor_to_array_apply(zend_object_iterator* iter, void* puser) /* {{{ */
-{
-	zval* data;
-	zval* return_value = (zval*) puser;
-
-	data = iter->funcs->get_current_data(iter);
-
-	if (EG(exception)) {
-		return ZEND_HASH_APPLY_STOP;
-	}
-	if (Z_ISUNDEF_P(data)) {
-		return ZEND_HASH_APPLY_STOP;
-	}
-	Z_TRY_ADDREF_P(data);
-	add_next_index_zval(return_value, data);
-
-	return ZEND_HASH_APPLY_KEEP;
-} /* }}} */
-
 static void php_phongo_cursor_id_new_from_id(zval* object, int64_t cursorid) /* {{{ */
 {
 	php_phongo_cursorid_t* intern;
@@ -133,7 +193,8 @@ static void php_phongo_cursor_id_new_from_id(zval* object, int64_t cursorid) /*
    Returns an array of all result documents for this cursor */
 static PHP_METHOD(Cursor, toArray)
 {
-	zend_error_handling error_handling;
+	zend_error_handling  error_handling;
+	php_phongo_cursor_t* intern;
 
 	zend_replace_error_handling(EH_THROW, phongo_exception_from_phongo_domain(PHONGO_ERROR_INVALID_ARGUMENT), &error_handling);
 	if (zend_parse_parameters_none() == FAILURE) {
@@ -142,9 +203,27 @@ static PHP_METHOD(Cursor, toArray)
 	}
 	zend_restore_error_handling(&error_handling);
 
+	intern = Z_CURSOR_OBJ_P(getThis());
+
 	array_init(return_value);
+	zend_hash_real_init_packed(Z_ARRVAL_P(return_value));
 
-	if (spl_iterator_apply(getThis(), php_phongo_cursor_to_array_apply, (void*) return_value) != SUCCESS) {
+	if (!php_phongo_cursor_rewind(intern)) {
+		zval_dtor(return_value);
+		RETURN_NULL();
+	}
+
+	/* Iterate directly instead of through the Iterator methods. Each decoded
+	 * document is moved into the result, since advancing the cursor would
+	 * release the cursor's reference to it anyway. */
+	while (!Z_ISUNDEF(intern->visitor_data.zchild)) {
+		zend_hash_next_index_insert_new(Z_ARRVAL_P(return_value), &intern->visitor_data.zchild);
+		ZVAL_UNDEF(&intern->visitor_data.zchild);
+
+		php_phongo_cursor_next(intern);
+	}
+
+	if (EG(exception)) {
 		zval_dtor(return_value);
 		RETURN_NULL();
 	}
@@ -250,9 +329,7 @@ PHP_METHOD(Cursor, key)
 
 PHP_METHOD(Cursor, next)
 {
-	zend_error_handling  error_handling;
-	php_phongo_cursor_t* intern = Z_CURSOR_OBJ_P(getThis());
-	const bson_t*        doc;
+	zend_error_handling error_handling;
 
 	zend_replace_error_handling(EH_THROW, phongo_exception_from_phongo_domain(PHONGO_ERROR_INVALID_ARGUMENT), &error_handling);
 	if (zend_parse_parameters_none() == FAILURE) {
@@ -261,35 +338,7 @@ PHP_METHOD(Cursor, next)
 	}
 	zend_restore_error_handling(&error_handling);
 
-	php_phongo_cursor_free_current(intern);
-
-	/* If the intern has already advanced, increment its position. Otherwise,
-	 * the first call to mongoc_cursor_next() will be made below and we should
-	 * leave its position at zero. */
-	if (intern->advanced) {
-		intern->current++;
-	} else {
-		intern->advanced = true;
-	}
-
-	if (mongoc_cursor_next(intern->cursor, &doc)) {
-		if (!php_phongo_bson_to_zval_ex(bson_get_data(doc), doc->len, &intern->visitor_data)) {
-			/* Free invalid result, but don't return as we want to free the
-			 * session if the intern is exhausted. */
-			php_phongo_cursor_free_current(intern);
-		}
-	} else {
-		bson_error_t  error = { 0 };
-		const bson_t* doc   = NULL;
-
-		if (mongoc_cursor_error_document(intern->cursor, &error, &doc)) {
-			/* Intentionally not destroying the intern as it will happen
-			 * naturally now that there are no more results */
-			phongo_throw_exception_from_bson_error_t_and_reply(&error, doc);
-		}
-	}
-
-	php_phongo_cursor_free_session_if_exhausted(intern);
+	php_phongo_cursor_next(Z_CURSOR_OBJ_P(getThis()));
 }
 
 PHP_METHOD(Cursor, valid)
@@ -309,9 +358,7 @@ PHP_METHOD(Cursor, valid)
 
 PHP_METHOD(Cursor, rewind)
 {
-	zend_error_handling  error_handling;
-	php_phongo_cursor_t* intern = Z_CURSOR_OBJ_P(getThis());
-	const bson_t*        doc;
+	zend_error_handling error_handling;
 
 	zend_replace_error_handling(EH_THROW, phongo_exception_from_phongo_domain(PHONGO_ERROR_INVALID_ARGUMENT), &error_handling);
 	if (zend_parse_parameters_none() == FAILURE) {
@@ -320,34 +367,7 @@ PHP_METHOD(Cursor, rewind)
 	}
 	zend_restore_error_handling(&error_handling);
 
-	/* If the intern was never advanced (e.g. command intern), do so now */
-	if (!intern->advanced) {
-		intern->advanced = true;
-
-		if (!phongo_cursor_advance_and_check_for_error(intern->cursor)) {
-			/* Exception should already have been thrown */
-			return;
-		}
-	}
-
-	if (intern->current > 0) {
-		phongo_throw_exception(PHONGO_ERROR_LOGIC, "Cursors cannot rewind after starting iteration");
-		return;
-	}
-
-	php_phongo_cursor_free_current(intern);
-
-	doc = mongoc_cursor_current(intern->cursor);
-
-	if (doc) {
-		if (!php_phongo_bson_to_zval_ex(bson_get_data(doc), doc->len, &intern->visitor_data)) {
-			/* Free invalid result, but don't return as we want to free the
-			 * session if the intern is exhausted. */
-			php_phongo_cursor_free_current(intern);
-		}
-	}
-
-	php_phongo_cursor_free_session_if_exhausted(intern);
+	php_phongo_cursor_rewind(Z_CURSOR_OBJ_P(getThis()));
 }
 
 /* {{{ MongoDB\Driver\Cursor function entries */
@@ -443,6 +463,10 @@ static void php_phongo_cursor_free_object(zend_object* object) /* {{{ */
 	php_phongo_bson_typemap_dtor(&intern->visitor_data.map);
 
 	php_phongo_cursor_free_current(intern);
+
+	if (intern->visitor_data.key_cache) {
+		php_phongo_bson_key_cache_free(intern->visitor_data.key_cache);
+	}
 } /* }}} */
 
 static zend_object* php_phongo_cursor_create_object(zend_class_entry* class_type) /* {{{ */
@@ -454,6 +478,9 @@ static zend_object* php_phongo_cursor_create_object(zend_class_entry* class_type
 
 	PHONGO_SET_CREATED_BY_PID(intern);
 
+	/* Documents in a cursor typically share the same field names */
+	intern->visitor_data.key_cache = php_phongo_bson_key_cache_new();
+
 	intern->std.handlers = &php_phongo_handler_cursor;
 
 	return &intern->std;
@@ -125,7 +125,7 @@ PHP_METHOD(CommandFailedEvent, getReply)
 	}
 	zend_restore_error_handling(&error_handling);
 
-	if (!php_phongo_bson_to_zval_ex(bson_get_data(intern->reply), intern->reply->len, &state)) {
+	if (!php_phongo_bson_doc_to_zval_ex(intern->reply, &state)) {
 		zval_ptr_dtor(&state.zchild);
 		return;
 	}
@@ -292,7 +292,7 @@ static HashTable* php_phongo_commandfailedevent_get_debug_info(phongo_compat_obj
 	sprintf(operation_id, "%" PRIu64, intern->operation_id);
 	ADD_ASSOC_STRING(&retval, "operationId", operation_id);
 
-	if (!php_phongo_bson_to_zval_ex(bson_get_data(intern->reply), intern->reply->len, &reply_state)) {
+	if (!php_phongo_bson_doc_to_zval_ex(intern->reply, &reply_state)) {
 		zval_ptr_dtor(&reply_state.zchild);
 		goto done;
 	}
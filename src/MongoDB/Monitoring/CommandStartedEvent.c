@@ -47,7 +47,7 @@ PHP_METHOD(CommandStartedEvent, getCommand)
 	}
 	zend_restore_error_handling(&error_handling);
 
-	if (!php_phongo_bson_to_zval_ex(bson_get_data(intern->command), intern->command->len, &state)) {
+	if (!php_phongo_bson_doc_to_zval_ex(intern->command, &state)) {
 		zval_ptr_dtor(&state.zchild);
 		return;
 	}
@@ -263,7 +263,7 @@ static HashTable* php_phongo_commandstartedevent_get_debug_info(phongo_compat_ob
 	*is_temp = 1;
 	array_init_size(&retval, 6);
 
-	if (!php_phongo_bson_to_zval_ex(bson_get_data(intern->command), intern->command->len, &command_state)) {
+	if (!php_phongo_bson_doc_to_zval_ex(intern->command, &command_state)) {
 		zval_ptr_dtor(&command_state.zchild);
 		goto done;
 	}
@@ -361,7 +361,7 @@ static PHP_METHOD(ReadPreference, getHedge)
 
 		PHONGO_BSON_INIT_STATE(state);
 
-		if (!php_phongo_bson_to_zval_ex(bson_get_data(hedge), hedge->len, &state)) {
+		if (!php_phongo_bson_doc_to_zval_ex(hedge, &state)) {
 			zval_ptr_dtor(&state.zchild);
 			return;
 		}
@@ -460,7 +460,7 @@ static PHP_METHOD(ReadPreference, getTagSets)
 
 		PHONGO_BSON_INIT_DEBUG_STATE(state);
 
-		if (!php_phongo_bson_to_zval_ex(bson_get_data(tags), tags->len, &state)) {
+		if (!php_phongo_bson_doc_to_zval_ex(tags, &state)) {
 			zval_ptr_dtor(&state.zchild);
 			return;
 		}
@@ -508,7 +508,7 @@ static HashTable* php_phongo_readpreference_get_properties_hash(phongo_compat_ob
 		PHONGO_BSON_INIT_STATE(state);
 		state.map.root_type = PHONGO_TYPEMAP_NATIVE_ARRAY;
 
-		if (!php_phongo_bson_to_zval_ex(bson_get_data(tags), tags->len, &state)) {
+		if (!php_phongo_bson_doc_to_zval_ex(tags, &state)) {
 			zval_ptr_dtor(&state.zchild);
 			goto done;
 		}
@@ -531,7 +531,7 @@ static HashTable* php_phongo_readpreference_get_properties_hash(phongo_compat_ob
 
 		PHONGO_BSON_INIT_STATE(state);
 
-		if (!php_phongo_bson_to_zval_ex(bson_get_data(hedge), hedge->len, &state)) {
+		if (!php_phongo_bson_doc_to_zval_ex(hedge, &state)) {
 			zval_ptr_dtor(&state.zchild);
 			goto done;
 		}
@@ -605,7 +605,7 @@ static PHP_METHOD(ReadPreference, serialize)
 
 		PHONGO_BSON_INIT_DEBUG_STATE(state);
 
-		if (!php_phongo_bson_to_zval_ex(bson_get_data(tags), tags->len, &state)) {
+		if (!php_phongo_bson_doc_to_zval_ex(tags, &state)) {
 			zval_ptr_dtor(&state.zchild);
 			return;
 		}
@@ -622,7 +622,7 @@ static PHP_METHOD(ReadPreference, serialize)
 
 		PHONGO_BSON_INIT_STATE(state);
 
-		if (!php_phongo_bson_to_zval_ex(bson_get_data(hedge), hedge->len, &state)) {
+		if (!php_phongo_bson_doc_to_zval_ex(hedge, &state)) {
 			zval_ptr_dtor(&state.zchild);
 			return;
 		}
@@ -24,20 +24,34 @@
 #include "php_phongo.h"
 #include "phongo_bson.h"
 #include "phongo_error.h"
+#include "phongo_probes.h"
+
+#include "BSON/Document.h"
+#include "BSON/PackedArray.h"
 
 #undef MONGOC_LOG_DOMAIN
 #define MONGOC_LOG_DOMAIN "PHONGO-BSON"
 
+ZEND_EXTERN_MODULE_GLOBALS(mongodb)
+
 #define PHONGO_IS_CLASS_INSTANTIATABLE(ce) \
 	(!(ce->ce_flags & (ZEND_ACC_INTERFACE | ZEND_ACC_IMPLICIT_ABSTRACT_CLASS | ZEND_ACC_EXPLICIT_ABSTRACT_CLASS)))
 
-#define PHONGO_BSON_STATE_ZCHILD(state) (&((php_phongo_bson_state*) (state))->zchild)
-
 #define PHONGO_FIELD_PATH_EXPANSION 8
 
+/* Maximum number of compiled type maps cached per request */
+#define PHONGO_TYPEMAP_CACHE_SIZE 64
+
+/* Maximum number of distinct field names retained by a key cache */
+#define PHONGO_KEY_CACHE_SIZE 256
+
+/* Maximum number of ODM class names resolved and cached per request */
+#define PHONGO_ODM_CLASS_CACHE_SIZE 1024
+
 /* Forward declarations */
 static bool php_phongo_bson_visit_document(const bson_iter_t* iter ARG_UNUSED, const char* key, const bson_t* v_document, void* data);
 static bool php_phongo_bson_visit_array(const bson_iter_t* iter ARG_UNUSED, const char* key, const bson_t* v_document, void* data);
+static const bson_visitor_t php_bson_path_visitors;
 
 /* Path builder */
 char* php_phongo_field_path_as_string(php_phongo_field_path* field_path)
@@ -176,13 +190,31 @@ static void php_phongo_bson_state_ctor(php_phongo_bson_state* state)
 
 static void php_phongo_bson_state_copy_ctor(php_phongo_bson_state* dst, php_phongo_bson_state* src)
 {
-	dst->map = src->map;
+	dst->map       = src->map;
+	dst->key_cache = src->key_cache;
 	if (src->field_path) {
 		src->field_path->ref_count++;
 	}
 	dst->field_path = src->field_path;
 }
 
+/* Field paths are only tracked while decoding if a fieldPaths type map needs
+ * to match them. Otherwise, the state has no field path and the path of a
+ * decoding error is determined after the fact. */
+static inline void php_phongo_bson_state_push_field_path(php_phongo_bson_state* state, const char* key, php_phongo_bson_field_path_item_types type)
+{
+	if (state->field_path) {
+		php_phongo_field_path_push(state->field_path, key, type);
+	}
+}
+
+static inline void php_phongo_bson_state_pop_field_path(php_phongo_bson_state* state)
+{
+	if (state->field_path) {
+		php_phongo_field_path_pop(state->field_path);
+	}
+}
+
 static void php_phongo_bson_state_dtor(php_phongo_bson_state* state)
 {
 	if (state->field_path) {
@@ -195,117 +227,382 @@ static void php_phongo_bson_state_dtor(php_phongo_bson_state* state)
 	}
 } /* }}} */
 
-static void php_phongo_bson_visit_corrupt(const bson_iter_t* iter ARG_UNUSED, void* data ARG_UNUSED) /* {{{ */
+/* Key caches hold the field names seen while decoding a series of documents
+ * (e.g. the results of a cursor), so that documents sharing a schema also share
+ * their key strings instead of allocating and hashing them for every field. */
+HashTable* php_phongo_bson_key_cache_new(void) /* {{{ */
 {
-	mongoc_log(MONGOC_LOG_LEVEL_WARNING, MONGOC_LOG_DOMAIN, "Corrupt BSON data detected!");
+	HashTable* key_cache;
+
+	ALLOC_HASHTABLE(key_cache);
+	zend_hash_init(key_cache, 16, NULL, ZVAL_PTR_DTOR, 0);
+
+	return key_cache;
 } /* }}} */
 
-static void php_phongo_bson_visit_unsupported_type(const bson_iter_t* iter ARG_UNUSED, const char* key, uint32_t v_type_code, void* data ARG_UNUSED) /* {{{ */
+void php_phongo_bson_key_cache_free(HashTable* key_cache) /* {{{ */
 {
-	php_phongo_bson_state* state = (php_phongo_bson_state*) data;
-	char*                  path_string;
+	zend_hash_destroy(key_cache);
+	FREE_HASHTABLE(key_cache);
+} /* }}} */
+
+/* Returns the cached string for a field name, adding it to the cache if there
+ * is room. The string is owned by the cache. NULL is returned if the key is
+ * not cached and the cache is full. */
+static zend_string* php_phongo_bson_key_cache_find(HashTable* key_cache, const char* key) /* {{{ */
+{
+	size_t key_len = strlen(key);
+	zval*  cached;
+	zval   zkey;
 
-	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
-	path_string = php_phongo_field_path_as_string(state->field_path);
+	if ((cached = zend_hash_str_find(key_cache, key, key_len))) {
+		return Z_STR_P(cached);
+	}
 
-	phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE, "Detected unknown BSON type 0x%02hhx for field path \"%s\". Are you using the latest driver?", (unsigned char) v_type_code, path_string);
+	if (zend_hash_num_elements(key_cache) >= PHONGO_KEY_CACHE_SIZE) {
+		return NULL;
+	}
 
-	efree(path_string);
+	/* Compute the hash once, so that arrays sharing the string need not */
+	ZVAL_STR(&zkey, zend_string_init(key, key_len, 0));
+	zend_string_hash_val(Z_STR(zkey));
+	zend_hash_add_new(key_cache, Z_STR(zkey), &zkey);
+
+	return Z_STR(zkey);
 } /* }}} */
 
-static bool php_phongo_bson_visit_double(const bson_iter_t* iter ARG_UNUSED, const char* key, double v_double, void* data) /* {{{ */
+static bool php_phongo_bson_state_hydrate_property(php_phongo_bson_state* state, const char* key, zval* zv);
+
+/* Adds a value to the array or property table being built for the current
+ * document or array. Ownership of the zval is transferred. Keys are disregarded
+ * when visiting an array. When visiting a document that will be returned as a
+ * stdClass, keys are added to the property table as-is, since properties are
+ * never stored under integer keys. Returns true if the value was rejected by a
+ * hydrated object, in which case an exception was thrown and visitors return
+ * true to stop iteration. */
+static inline bool php_phongo_bson_state_add_zval(php_phongo_bson_state* state, const char* key, zval* zv) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
+	zend_string* zkey;
+
+	if (state->hydrate) {
+		return php_phongo_bson_state_hydrate_property(state, key, zv);
+	} else if (state->is_visiting_array) {
+		add_next_index_zval(&state->zchild, zv);
+	} else if (state->key_cache && (zkey = php_phongo_bson_key_cache_find(state->key_cache, key))) {
+		if (state->is_visiting_object) {
+			zend_hash_update(Z_ARRVAL(state->zchild), zkey, zv);
+		} else {
+			zend_symtable_update(Z_ARRVAL(state->zchild), zkey, zv);
+		}
+	} else if (state->is_visiting_object) {
+		zend_hash_str_update(Z_ARRVAL(state->zchild), key, strlen(key), zv);
+	} else {
+		ADD_ASSOC_ZVAL(&state->zchild, key, zv);
+	}
+
+	return false;
+} /* }}} */
+
+/* Returns whether a field is excluded by the include or exclude type map
+ * entries. If the field is included and child is not NULL, it is assigned the
+ * filter node to apply to an embedded document or array (NULL if all of its
+ * fields are included). Arrays are transparent: their elements are filtered
+ * using the paths that apply to the array itself, so embedded documents are
+ * filtered by the array's node and scalars follow the same rule as a scalar
+ * field whose path continues past it. */
+static inline bool php_phongo_bson_state_skip_field(php_phongo_bson_state* state, const char* key, php_phongo_field_path_node** child) /* {{{ */
+{
+	php_phongo_field_path_node* node  = state->filter_node;
+	php_phongo_field_path_node* found = NULL;
+
+	if (child) {
+		*child = NULL;
+	}
+
+	if (!node) {
+		return false;
+	}
 
 	if (state->is_visiting_array) {
-		add_next_index_double(retval, v_double);
+		found = node;
+	} else {
+		/* Wildcard paths were merged into their exact siblings when the filter
+		 * was compiled, so an exact match also covers the wildcard branch */
+		if (node->children) {
+			found = zend_hash_str_find_ptr(node->children, key, strlen(key));
+		}
+
+		if (!found) {
+			found = node->wildcard;
+		}
+	}
+
+	if (state->map.field_filter_exclude) {
+		if (!found) {
+			return false;
+		}
+
+		if (found->order) {
+			return true;
+		}
 	} else {
-		add_assoc_double(retval, key, v_double);
+		if (!found) {
+			return true;
+		}
+
+		if (found->order) {
+			return false;
+		}
+	}
+
+	/* Only some fields within the embedded value are included or excluded. A
+	 * scalar value has no such fields, so it is only kept if excluding. */
+	if (!child) {
+		return !state->map.field_filter_exclude;
 	}
 
-	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
+	*child = found;
 
 	return false;
 } /* }}} */
 
-static bool php_phongo_bson_visit_utf8(const bson_iter_t* iter ARG_UNUSED, const char* key, size_t v_utf8_len, const char* v_utf8, void* data) /* {{{ */
+/* Initializes the zval that will collect the fields of a document, pre-sized
+ * for its number of keys. Documents that will be returned as a stdClass collect
+ * their fields in a property table, which is later handed over to the object
+ * as-is (see php_phongo_bson_state_zchild_to_object()). */
+static void php_phongo_bson_state_init_document(php_phongo_bson_state* state, const bson_t* document, php_phongo_bson_typemap_types type) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
+	state->is_visiting_object = (type == PHONGO_TYPEMAP_NONE || type == PHONGO_TYPEMAP_NATIVE_OBJECT);
 
-	if (state->is_visiting_array) {
-		ADD_NEXT_INDEX_STRINGL(retval, v_utf8, v_utf8_len);
-	} else {
-		ADD_ASSOC_STRING_EX(retval, key, strlen(key), v_utf8, v_utf8_len);
+	array_init_size(&state->zchild, bson_count_keys(document));
+} /* }}} */
+
+/* Returns whether a class type map entry is hydrated directly into the declared
+ * properties of its class instead of being passed to bsonUnserialize(). This
+ * applies to classes implementing MongoDB\BSON\PropertyCodec but not
+ * MongoDB\BSON\Unserializable. */
+static bool php_phongo_bson_is_hydrated_class(php_phongo_bson_typemap_types type, zend_class_entry* ce) /* {{{ */
+{
+	return type == PHONGO_TYPEMAP_CLASS && ce && instanceof_function(ce, php_phongo_propertycodec_ce) && !instanceof_function(ce, php_phongo_unserializable_ce);
+} /* }}} */
+
+/* Initializes the object that will be hydrated with the fields of a document.
+ * The constructor is not called. Fields are written to the object's property
+ * slots as they are visited, so no array is collected for the document. */
+static void php_phongo_bson_state_init_hydrate(php_phongo_bson_state* state, zend_class_entry* ce) /* {{{ */
+{
+	object_init_ex(&state->zchild, ce);
+
+	state->hydrate            = Z_OBJ(state->zchild);
+	state->is_visiting_object = false;
+} /* }}} */
+
+/* Writes a visited value to the declared property of the same name. Fields
+ * without a matching non-static property are discarded. Values are coerced to
+ * the type of a typed property as in non-strict mode; if that fails, a
+ * TypeError is thrown, the value is discarded, and true is returned. Hooked
+ * properties (PHP 8.4+) are assigned through their set hook, and virtual
+ * properties are discarded. Ownership of the zval is transferred. */
+static bool php_phongo_bson_state_hydrate_property(php_phongo_bson_state* state, const char* key, zval* zv) /* {{{ */
+{
+	zend_property_info* prop_info = zend_hash_str_find_ptr(&state->hydrate->ce->properties_info, key, strlen(key));
+	zval*               slot;
+
+	if (!prop_info || (prop_info->flags & ZEND_ACC_STATIC)) {
+		zval_ptr_dtor(zv);
+		return false;
+	}
+
+#ifdef ZEND_ACC_SHADOW
+	if (prop_info->flags & ZEND_ACC_SHADOW) {
+		zval_ptr_dtor(zv);
+		return false;
+	}
+#endif
+
+#ifdef ZEND_ACC_VIRTUAL
+	/* Virtual properties have no slot, and are not encoded either */
+	if (prop_info->flags & ZEND_ACC_VIRTUAL) {
+		zval_ptr_dtor(zv);
+		return false;
+	}
+#endif
+
+#if PHP_VERSION_ID >= 80400
+	/* Hooked properties are assigned through their set hook */
+	if (prop_info->hooks) {
+		zend_string* name = zend_string_init(key, strlen(key), 0);
+
+		zend_update_property_ex(prop_info->ce, state->hydrate, name, zv);
+		zend_string_release(name);
+		zval_ptr_dtor(zv);
+
+		return EG(exception) != NULL;
+	}
+#endif
+
+#if PHP_VERSION_ID >= 70400
+	if (ZEND_TYPE_IS_SET(prop_info->type) && !zend_verify_property_type(prop_info, zv, 0)) {
+		zval_ptr_dtor(zv);
+		return true;
 	}
+#endif
 
-	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
+	slot = OBJ_PROP(state->hydrate, prop_info->offset);
+	zval_ptr_dtor(slot);
+	ZVAL_COPY_VALUE(slot, zv);
+
+#if PHP_VERSION_ID >= 70400
+	/* The slot is now initialized, as it would be after zend_std_write_property() */
+	Z_PROP_FLAG_P(slot) &= ~IS_PROP_UNINIT;
+#endif
 
 	return false;
 } /* }}} */
 
+/* Converts a property table collected for a document to a symbol table, so it
+ * may be used as a PHP array (e.g. when an ODM class is found for a document
+ * that would otherwise have been returned as a stdClass). */
+static void php_phongo_bson_state_zchild_to_array(zval* zchild) /* {{{ */
+{
+	HashTable* ht = zend_proptable_to_symtable(Z_ARRVAL_P(zchild), 0);
+
+	zval_ptr_dtor(zchild);
+	ZVAL_ARR(zchild, ht);
+} /* }}} */
+
+/* Creates a stdClass using the property table collected for a document. The
+ * object takes over the table without copying or rehashing it. */
+static void php_phongo_bson_state_zchild_to_object(zval* zchild) /* {{{ */
+{
+	zval obj;
+
+	object_and_properties_init(&obj, zend_standard_class_def, Z_ARRVAL_P(zchild));
+	ZVAL_COPY_VALUE(zchild, &obj);
+} /* }}} */
+
+static void php_phongo_bson_visit_corrupt(const bson_iter_t* iter ARG_UNUSED, void* data ARG_UNUSED) /* {{{ */
+{
+	mongoc_log(MONGOC_LOG_LEVEL_WARNING, MONGOC_LOG_DOMAIN, "Corrupt BSON data detected!");
+} /* }}} */
+
+static void php_phongo_bson_visit_unsupported_type(const bson_iter_t* iter ARG_UNUSED, const char* key ARG_UNUSED, uint32_t v_type_code ARG_UNUSED, void* data ARG_UNUSED) /* {{{ */
+{
+	/* Iteration stops with an error offset. The exception is thrown once the
+	 * field path has been determined (see php_phongo_bson_throw_visit_error) */
+} /* }}} */
+
+static bool php_phongo_bson_visit_double(const bson_iter_t* iter ARG_UNUSED, const char* key, double v_double, void* data) /* {{{ */
+{
+	php_phongo_bson_state* state = (php_phongo_bson_state*) data;
+	zval                   zchild;
+
+	if (php_phongo_bson_state_skip_field(state, key, NULL)) {
+		return false;
+	}
+
+	ZVAL_DOUBLE(&zchild, v_double);
+	return php_phongo_bson_state_add_zval(state, key, &zchild);
+} /* }}} */
+
+static bool php_phongo_bson_visit_utf8(const bson_iter_t* iter ARG_UNUSED, const char* key, size_t v_utf8_len, const char* v_utf8, void* data) /* {{{ */
+{
+	php_phongo_bson_state* state = (php_phongo_bson_state*) data;
+	zval                   zchild;
+
+	if (php_phongo_bson_state_skip_field(state, key, NULL)) {
+		return false;
+	}
+
+	ZVAL_STRINGL(&zchild, v_utf8, v_utf8_len);
+	return php_phongo_bson_state_add_zval(state, key, &zchild);
+} /* }}} */
+
 static void php_phongo_bson_new_binary_from_binary_and_type(zval* object, const char* data, size_t data_len, bson_subtype_t type) /* {{{ */
 {
 	php_phongo_binary_t* intern;
 
 	object_init_ex(object, php_phongo_binary_ce);
 
-	intern           = Z_BINARY_OBJ_P(object);
-	intern->data     = estrndup(data, data_len);
-	intern->data_len = data_len;
-	intern->type     = (uint8_t) type;
+	intern       = Z_BINARY_OBJ_P(object);
+	intern->data = zend_string_init(data, data_len, 0);
+	intern->type = (uint8_t) type;
+} /* }}} */
+
+/* Returns the class named by an ODM field if it is an instantiatable class
+ * implementing Persistable; otherwise, NULL is returned. Results, including
+ * names that did not resolve to such a class, are cached for the duration of
+ * the request so that each class is only looked up and autoloaded once. */
+static zend_class_entry* php_phongo_bson_fetch_odm_class(const char* classname, size_t classname_len) /* {{{ */
+{
+	HashTable*        cache = MONGODB_G(odm_class_cache);
+	zval*             cached;
+	zend_string*      zs_classname;
+	zend_class_entry* found_ce;
+
+	if (cache && (cached = zend_hash_str_find(cache, classname, classname_len))) {
+		MONGODB_G(odm_class_cache_hits)++;
+		return Z_PTR_P(cached);
+	}
+
+	MONGODB_G(odm_class_cache_misses)++;
+
+	zs_classname = zend_string_init(classname, classname_len, 0);
+	found_ce     = zend_fetch_class(zs_classname, ZEND_FETCH_CLASS_AUTO | ZEND_FETCH_CLASS_SILENT);
+	zend_string_release(zs_classname);
+
+	if (found_ce && !(PHONGO_IS_CLASS_INSTANTIATABLE(found_ce) && instanceof_function(found_ce, php_phongo_persistable_ce))) {
+		found_ce = NULL;
+	}
+
+	/* Do not cache the result if an autoloader threw, as the class may still
+	 * be resolved by a later attempt. */
+	if (cache && !EG(exception) && zend_hash_num_elements(cache) < PHONGO_ODM_CLASS_CACHE_SIZE) {
+		zend_hash_str_add_ptr(cache, classname, classname_len, found_ce);
+	}
+
+	return found_ce;
 } /* }}} */
 
 static bool php_phongo_bson_visit_binary(const bson_iter_t* iter ARG_UNUSED, const char* key, bson_subtype_t v_subtype, size_t v_binary_len, const uint8_t* v_binary, void* data) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
+	php_phongo_bson_state* state = (php_phongo_bson_state*) data;
+	zval                   zchild;
 
+	/* The ODM class is detected even if the field itself is filtered out */
 	if (v_subtype == 0x80 && strcmp(key, PHONGO_ODM_FIELD_NAME) == 0) {
-		zend_string*      zs_classname = zend_string_init((const char*) v_binary, v_binary_len, 0);
-		zend_class_entry* found_ce     = zend_fetch_class(zs_classname, ZEND_FETCH_CLASS_AUTO | ZEND_FETCH_CLASS_SILENT);
-		zend_string_release(zs_classname);
+		zend_class_entry* found_ce = php_phongo_bson_fetch_odm_class((const char*) v_binary, v_binary_len);
 
-		if (found_ce && PHONGO_IS_CLASS_INSTANTIATABLE(found_ce) && instanceof_function(found_ce, php_phongo_persistable_ce)) {
-			((php_phongo_bson_state*) data)->odm = found_ce;
+		if (found_ce) {
+			state->odm = found_ce;
 		}
 	}
 
-	{
-		zval zchild;
+	if (php_phongo_bson_state_skip_field(state, key, NULL)) {
+		return false;
+	}
 
+	if (state->map.scalar_types & PHONGO_TYPEMAP_SCALAR_BINARY) {
+		ZVAL_STRINGL(&zchild, (const char*) v_binary, v_binary_len);
+	} else {
 		php_phongo_bson_new_binary_from_binary_and_type(&zchild, (const char*) v_binary, v_binary_len, v_subtype);
-
-		if (state->is_visiting_array) {
-			add_next_index_zval(retval, &zchild);
-		} else {
-			ADD_ASSOC_ZVAL(retval, key, &zchild);
-		}
 	}
 
-	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
-
-	return false;
+	return php_phongo_bson_state_add_zval(state, key, &zchild);
 } /* }}} */
 
 static bool php_phongo_bson_visit_undefined(const bson_iter_t* iter, const char* key, void* data) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
+	php_phongo_bson_state* state = (php_phongo_bson_state*) data;
 	zval                   zchild;
 
-	object_init_ex(&zchild, php_phongo_undefined_ce);
-
-	if (state->is_visiting_array) {
-		add_next_index_zval(retval, &zchild);
-	} else {
-		ADD_ASSOC_ZVAL(retval, key, &zchild);
+	if (php_phongo_bson_state_skip_field(state, key, NULL)) {
+		return false;
 	}
 
-	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
+	object_init_ex(&zchild, php_phongo_undefined_ce);
 
-	return false;
+	return php_phongo_bson_state_add_zval(state, key, &zchild);
 } /* }}} */
 
 static void php_phongo_objectid_new_from_oid(zval* object, const bson_oid_t* oid) /* {{{ */
@@ -315,43 +612,40 @@ static void php_phongo_objectid_new_from_oid(zval* object, const bson_oid_t* oid
 	object_init_ex(object, php_phongo_objectid_ce);
 
 	intern = Z_OBJECTID_OBJ_P(object);
-	bson_oid_to_string(oid, intern->oid);
+	bson_oid_copy(oid, &intern->oid);
 	intern->initialized = true;
 } /* }}} */
 
 static bool php_phongo_bson_visit_oid(const bson_iter_t* iter ARG_UNUSED, const char* key, const bson_oid_t* v_oid, void* data) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
+	php_phongo_bson_state* state = (php_phongo_bson_state*) data;
 	zval                   zchild;
 
-	php_phongo_objectid_new_from_oid(&zchild, v_oid);
+	if (php_phongo_bson_state_skip_field(state, key, NULL)) {
+		return false;
+	}
 
-	if (state->is_visiting_array) {
-		add_next_index_zval(retval, &zchild);
+	if (state->map.scalar_types & PHONGO_TYPEMAP_SCALAR_OBJECTID) {
+		ZVAL_NEW_STR(&zchild, zend_string_alloc(24, 0));
+		bson_oid_to_string(v_oid, Z_STRVAL(zchild));
 	} else {
-		ADD_ASSOC_ZVAL(retval, key, &zchild);
+		php_phongo_objectid_new_from_oid(&zchild, v_oid);
 	}
 
-	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
-
-	return false;
+	return php_phongo_bson_state_add_zval(state, key, &zchild);
 } /* }}} */
 
 static bool php_phongo_bson_visit_bool(const bson_iter_t* iter ARG_UNUSED, const char* key, bool v_bool, void* data) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
+	php_phongo_bson_state* state = (php_phongo_bson_state*) data;
+	zval                   zchild;
 
-	if (state->is_visiting_array) {
-		add_next_index_bool(retval, v_bool);
-	} else {
-		add_assoc_bool(retval, key, v_bool);
+	if (php_phongo_bson_state_skip_field(state, key, NULL)) {
+		return false;
 	}
 
-	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
-
-	return false;
+	ZVAL_BOOL(&zchild, v_bool);
+	return php_phongo_bson_state_add_zval(state, key, &zchild);
 } /* }}} */
 
 static void php_phongo_bson_new_utcdatetime_from_epoch(zval* object, int64_t msec_since_epoch) /* {{{ */
@@ -367,21 +661,21 @@ static void php_phongo_bson_new_utcdatetime_from_epoch(zval* object, int64_t mse
 
 static bool php_phongo_bson_visit_date_time(const bson_iter_t* iter ARG_UNUSED, const char* key, int64_t msec_since_epoch, void* data) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
+	php_phongo_bson_state* state = (php_phongo_bson_state*) data;
 	zval                   zchild;
 
-	php_phongo_bson_new_utcdatetime_from_epoch(&zchild, msec_since_epoch);
+	if (php_phongo_bson_state_skip_field(state, key, NULL)) {
+		return false;
+	}
 
-	if (state->is_visiting_array) {
-		add_next_index_zval(retval, &zchild);
+	/* Only 64-bit platforms allow dates to be mapped to integers */
+	if (state->map.scalar_types & PHONGO_TYPEMAP_SCALAR_DATE) {
+		ZVAL_LONG(&zchild, (zend_long) msec_since_epoch);
 	} else {
-		ADD_ASSOC_ZVAL(retval, key, &zchild);
+		php_phongo_bson_new_utcdatetime_from_epoch(&zchild, msec_since_epoch);
 	}
 
-	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
-
-	return false;
+	return php_phongo_bson_state_add_zval(state, key, &zchild);
 } /* }}} */
 
 static void php_phongo_bson_new_decimal128(zval* object, const bson_decimal128_t* decimal) /* {{{ */
@@ -397,37 +691,36 @@ static void php_phongo_bson_new_decimal128(zval* object, const bson_decimal128_t
 
 static bool php_phongo_bson_visit_decimal128(const bson_iter_t* iter ARG_UNUSED, const char* key, const bson_decimal128_t* decimal, void* data) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
+	php_phongo_bson_state* state = (php_phongo_bson_state*) data;
 	zval                   zchild;
 
-	php_phongo_bson_new_decimal128(&zchild, decimal);
+	if (php_phongo_bson_state_skip_field(state, key, NULL)) {
+		return false;
+	}
 
-	if (state->is_visiting_array) {
-		add_next_index_zval(retval, &zchild);
+	if (state->map.scalar_types & PHONGO_TYPEMAP_SCALAR_DECIMAL128) {
+		char outbuf[BSON_DECIMAL128_STRING] = "";
+
+		bson_decimal128_to_string(decimal, outbuf);
+		ZVAL_STRING(&zchild, outbuf);
 	} else {
-		ADD_ASSOC_ZVAL(retval, key, &zchild);
+		php_phongo_bson_new_decimal128(&zchild, decimal);
 	}
 
-	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
-
-	return false;
+	return php_phongo_bson_state_add_zval(state, key, &zchild);
 } /* }}} */
 
 static bool php_phongo_bson_visit_null(const bson_iter_t* iter ARG_UNUSED, const char* key, void* data) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
+	php_phongo_bson_state* state = (php_phongo_bson_state*) data;
+	zval                   zchild;
 
-	if (state->is_visiting_array) {
-		add_next_index_null(retval);
-	} else {
-		add_assoc_null(retval, key);
+	if (php_phongo_bson_state_skip_field(state, key, NULL)) {
+		return false;
 	}
 
-	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
-
-	return false;
+	ZVAL_NULL(&zchild);
+	return php_phongo_bson_state_add_zval(state, key, &zchild);
 } /* }}} */
 
 static void php_phongo_bson_new_regex_from_regex_and_options(zval* object, const char* pattern, const char* flags) /* {{{ */
@@ -445,21 +738,16 @@ static void php_phongo_bson_new_regex_from_regex_and_options(zval* object, const
 
 static bool php_phongo_bson_visit_regex(const bson_iter_t* iter ARG_UNUSED, const char* key, const char* v_regex, const char* v_options, void* data) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
+	php_phongo_bson_state* state = (php_phongo_bson_state*) data;
 	zval                   zchild;
 
-	php_phongo_bson_new_regex_from_regex_and_options(&zchild, v_regex, v_options);
-
-	if (state->is_visiting_array) {
-		add_next_index_zval(retval, &zchild);
-	} else {
-		ADD_ASSOC_ZVAL(retval, key, &zchild);
+	if (php_phongo_bson_state_skip_field(state, key, NULL)) {
+		return false;
 	}
 
-	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
+	php_phongo_bson_new_regex_from_regex_and_options(&zchild, v_regex, v_options);
 
-	return false;
+	return php_phongo_bson_state_add_zval(state, key, &zchild);
 } /* }}} */
 
 static void php_phongo_bson_new_symbol(zval* object, const char* symbol, size_t symbol_len) /* {{{ */
@@ -475,21 +763,16 @@ static void php_phongo_bson_new_symbol(zval* object, const char* symbol, size_t
 
 static bool php_phongo_bson_visit_symbol(const bson_iter_t* iter, const char* key, size_t v_symbol_len, const char* v_symbol, void* data) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
+	php_phongo_bson_state* state = (php_phongo_bson_state*) data;
 	zval                   zchild;
 
-	php_phongo_bson_new_symbol(&zchild, v_symbol, v_symbol_len);
-
-	if (state->is_visiting_array) {
-		add_next_index_zval(retval, &zchild);
-	} else {
-		ADD_ASSOC_ZVAL(retval, key, &zchild);
+	if (php_phongo_bson_state_skip_field(state, key, NULL)) {
+		return false;
 	}
 
-	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
+	php_phongo_bson_new_symbol(&zchild, v_symbol, v_symbol_len);
 
-	return false;
+	return php_phongo_bson_state_add_zval(state, key, &zchild);
 } /* }}} */
 
 static bool php_phongo_bson_new_javascript_from_javascript_and_scope(zval* object, const char* code, size_t code_len, const bson_t* scope) /* {{{ */
@@ -502,7 +785,7 @@ static bool php_phongo_bson_new_javascript_from_javascript_and_scope(zval* objec
 
 		PHONGO_BSON_INIT_STATE(state);
 
-		valid_scope = php_phongo_bson_to_zval_ex(bson_get_data(scope), scope->len, &state);
+		valid_scope = php_phongo_bson_doc_to_zval_ex(scope, &state);
 		zval_ptr_dtor(&state.zchild);
 
 		if (!valid_scope) {
@@ -527,23 +810,18 @@ static bool php_phongo_bson_new_javascript_from_javascript(zval* object, const c
 
 static bool php_phongo_bson_visit_code(const bson_iter_t* iter ARG_UNUSED, const char* key, size_t v_code_len, const char* v_code, void* data) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
+	php_phongo_bson_state* state = (php_phongo_bson_state*) data;
 	zval                   zchild;
 
-	if (!php_phongo_bson_new_javascript_from_javascript(&zchild, v_code, v_code_len)) {
-		return true;
+	if (php_phongo_bson_state_skip_field(state, key, NULL)) {
+		return false;
 	}
 
-	if (state->is_visiting_array) {
-		add_next_index_zval(retval, &zchild);
-	} else {
-		ADD_ASSOC_ZVAL(retval, key, &zchild);
+	if (!php_phongo_bson_new_javascript_from_javascript(&zchild, v_code, v_code_len)) {
+		return true;
 	}
 
-	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
-
-	return false;
+	return php_phongo_bson_state_add_zval(state, key, &zchild);
 } /* }}} */
 
 static void php_phongo_bson_new_dbpointer(zval* object, const char* ref, size_t ref_len, const bson_oid_t* oid) /* {{{ */
@@ -560,131 +838,100 @@ static void php_phongo_bson_new_dbpointer(zval* object, const char* ref, size_t
 
 static bool php_phongo_bson_visit_dbpointer(const bson_iter_t* iter, const char* key, size_t namespace_len, const char* namespace, const bson_oid_t* oid, void* data) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
+	php_phongo_bson_state* state = (php_phongo_bson_state*) data;
 	zval                   zchild;
 
-	php_phongo_bson_new_dbpointer(&zchild, namespace, namespace_len, oid);
-
-	if (state->is_visiting_array) {
-		add_next_index_zval(retval, &zchild);
-	} else {
-		ADD_ASSOC_ZVAL(retval, key, &zchild);
+	if (php_phongo_bson_state_skip_field(state, key, NULL)) {
+		return false;
 	}
 
-	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
+	php_phongo_bson_new_dbpointer(&zchild, namespace, namespace_len, oid);
 
-	return false;
+	return php_phongo_bson_state_add_zval(state, key, &zchild);
 } /* }}} */
 
 static bool php_phongo_bson_visit_codewscope(const bson_iter_t* iter ARG_UNUSED, const char* key, size_t v_code_len, const char* v_code, const bson_t* v_scope, void* data) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
+	php_phongo_bson_state* state = (php_phongo_bson_state*) data;
 	zval                   zchild;
 
-	if (!php_phongo_bson_new_javascript_from_javascript_and_scope(&zchild, v_code, v_code_len, v_scope)) {
-		return true;
+	if (php_phongo_bson_state_skip_field(state, key, NULL)) {
+		return false;
 	}
 
-	if (state->is_visiting_array) {
-		add_next_index_zval(retval, &zchild);
-	} else {
-		ADD_ASSOC_ZVAL(retval, key, &zchild);
+	if (!php_phongo_bson_new_javascript_from_javascript_and_scope(&zchild, v_code, v_code_len, v_scope)) {
+		return true;
 	}
 
-	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
-
-	return false;
+	return php_phongo_bson_state_add_zval(state, key, &zchild);
 } /* }}} */
 
 static bool php_phongo_bson_visit_int32(const bson_iter_t* iter ARG_UNUSED, const char* key, int32_t v_int32, void* data) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
+	php_phongo_bson_state* state = (php_phongo_bson_state*) data;
+	zval                   zchild;
 
-	if (state->is_visiting_array) {
-		add_next_index_long(retval, v_int32);
-	} else {
-		add_assoc_long(retval, key, v_int32);
+	if (php_phongo_bson_state_skip_field(state, key, NULL)) {
+		return false;
 	}
 
-	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
-
-	return false;
+	ZVAL_LONG(&zchild, v_int32);
+	return php_phongo_bson_state_add_zval(state, key, &zchild);
 } /* }}} */
 
 static bool php_phongo_bson_visit_timestamp(const bson_iter_t* iter ARG_UNUSED, const char* key, uint32_t v_timestamp, uint32_t v_increment, void* data) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
+	php_phongo_bson_state* state = (php_phongo_bson_state*) data;
 	zval                   zchild;
 
-	php_phongo_bson_new_timestamp_from_increment_and_timestamp(&zchild, v_increment, v_timestamp);
-
-	if (state->is_visiting_array) {
-		add_next_index_zval(retval, &zchild);
-	} else {
-		ADD_ASSOC_ZVAL(retval, key, &zchild);
+	if (php_phongo_bson_state_skip_field(state, key, NULL)) {
+		return false;
 	}
 
-	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
+	php_phongo_bson_new_timestamp_from_increment_and_timestamp(&zchild, v_increment, v_timestamp);
 
-	return false;
+	return php_phongo_bson_state_add_zval(state, key, &zchild);
 } /* }}} */
 
 static bool php_phongo_bson_visit_int64(const bson_iter_t* iter ARG_UNUSED, const char* key, int64_t v_int64, void* data) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
-
-	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
+	php_phongo_bson_state* state = (php_phongo_bson_state*) data;
+	zval                   zchild;
 
-	if (state->is_visiting_array) {
-		ADD_NEXT_INDEX_INT64(retval, v_int64);
-	} else {
-		ADD_ASSOC_INT64(retval, key, v_int64);
+	if (php_phongo_bson_state_skip_field(state, key, NULL)) {
+		return false;
 	}
 
-	return false;
+	ZVAL_INT64(&zchild, v_int64);
+	return php_phongo_bson_state_add_zval(state, key, &zchild);
 } /* }}} */
 
 static bool php_phongo_bson_visit_maxkey(const bson_iter_t* iter ARG_UNUSED, const char* key, void* data) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
+	php_phongo_bson_state* state = (php_phongo_bson_state*) data;
 	zval                   zchild;
 
-	object_init_ex(&zchild, php_phongo_maxkey_ce);
-
-	if (state->is_visiting_array) {
-		add_next_index_zval(retval, &zchild);
-	} else {
-		ADD_ASSOC_ZVAL(retval, key, &zchild);
+	if (php_phongo_bson_state_skip_field(state, key, NULL)) {
+		return false;
 	}
 
-	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
+	object_init_ex(&zchild, php_phongo_maxkey_ce);
 
-	return false;
+	return php_phongo_bson_state_add_zval(state, key, &zchild);
 } /* }}} */
 
 static bool php_phongo_bson_visit_minkey(const bson_iter_t* iter ARG_UNUSED, const char* key, void* data) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
+	php_phongo_bson_state* state = (php_phongo_bson_state*) data;
 	zval                   zchild;
 
-	object_init_ex(&zchild, php_phongo_minkey_ce);
-
-	if (state->is_visiting_array) {
-		add_next_index_zval(retval, &zchild);
-	} else {
-		ADD_ASSOC_ZVAL(retval, key, &zchild);
+	if (php_phongo_bson_state_skip_field(state, key, NULL)) {
+		return false;
 	}
 
-	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
+	object_init_ex(&zchild, php_phongo_minkey_ce);
 
-	return false;
+	return php_phongo_bson_state_add_zval(state, key, &zchild);
 } /* }}} */
 
 static const bson_visitor_t php_bson_visitors = {
@@ -716,45 +963,46 @@ static const bson_visitor_t php_bson_visitors = {
 	{ NULL }
 };
 
-static inline bool map_element_matches_field_path(php_phongo_field_path_map_element* map_element, php_phongo_field_path* current)
+/* Finds the field path map entry matching the current field path. Both the
+ * exact segment and the wildcard branch are explored at each level, and the
+ * entry that appeared first in the type map is returned. */
+static php_phongo_field_path_node* php_phongo_field_path_map_find(php_phongo_field_path_node* node, php_phongo_field_path* field_path, size_t level)
 {
-	size_t i;
+	php_phongo_field_path_node* found = NULL;
+	php_phongo_field_path_node* candidate;
 
-	if (map_element->entry->size != current->size) {
-		return false;
-	}
-	for (i = 0; i < current->size; i++) {
-		if (strcmp(map_element->entry->elements[i], "$") == 0) {
-			continue;
-		}
-		if (strcmp(map_element->entry->elements[i], current->elements[i]) != 0) {
-			return false;
-		}
+	if (level == field_path->size) {
+		return node->order ? node : NULL;
 	}
-	return true;
-}
 
-static php_phongo_field_path_map_element* map_find_field_path_entry(php_phongo_bson_state* state)
-{
-	size_t i;
+	if (node->children && (candidate = zend_hash_str_find_ptr(node->children, field_path->elements[level], strlen(field_path->elements[level])))) {
+		found = php_phongo_field_path_map_find(candidate, field_path, level + 1);
+	}
 
-	/* Loop over all field path mappings, and for each, try to see whether it matches the current path */
-	for (i = 0; i < state->map.field_paths.size; i++) {
-		if (map_element_matches_field_path(state->map.field_paths.map[i], state->field_path)) {
-			return state->map.field_paths.map[i];
+	if (node->wildcard && (candidate = php_phongo_field_path_map_find(node->wildcard, field_path, level + 1))) {
+		if (!found || candidate->order < found->order) {
+			found = candidate;
 		}
 	}
-	return NULL;
+
+	return found;
 }
 
 static void php_phongo_handle_field_path_entry_for_compound_type(php_phongo_bson_state* state, php_phongo_bson_typemap_types* type, zend_class_entry** ce)
 {
-	php_phongo_field_path_map_element* entry = map_find_field_path_entry(state);
+	php_phongo_field_path_node* entry;
+
+	if (!state->map.field_paths) {
+		return;
+	}
+
+	entry = php_phongo_field_path_map_find(&state->map.field_paths->root, state->field_path, 0);
 
 	if (entry) {
 		switch (entry->node_type) {
 			case PHONGO_TYPEMAP_NATIVE_ARRAY:
 			case PHONGO_TYPEMAP_NATIVE_OBJECT:
+			case PHONGO_TYPEMAP_BSON:
 				*type = entry->node_type;
 				break;
 			case PHONGO_TYPEMAP_CLASS:
@@ -770,25 +1018,51 @@ static void php_phongo_handle_field_path_entry_for_compound_type(php_phongo_bson
 
 static bool php_phongo_bson_visit_document(const bson_iter_t* iter ARG_UNUSED, const char* key, const bson_t* v_document, void* data) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	bson_iter_t            child;
-	php_phongo_bson_state* parent_state = (php_phongo_bson_state*) data;
+	bson_iter_t                 child;
+	php_phongo_bson_state*      parent_state = (php_phongo_bson_state*) data;
+	php_phongo_field_path_node* filter_node;
+
+	/* Filtered documents are skipped without visiting their fields */
+	if (php_phongo_bson_state_skip_field(parent_state, key, &filter_node)) {
+		return false;
+	}
 
-	php_phongo_field_path_push(parent_state->field_path, key, PHONGO_FIELD_PATH_ITEM_DOCUMENT);
+	php_phongo_bson_state_push_field_path(parent_state, key, PHONGO_FIELD_PATH_ITEM_DOCUMENT);
 
 	if (bson_iter_init(&child, v_document)) {
 		php_phongo_bson_state state;
 
 		PHONGO_BSON_INIT_STATE(state);
 		php_phongo_bson_state_copy_ctor(&state, parent_state);
+		state.filter_node = filter_node;
+
+		/* Check for entries in the fieldPath type map key, and use them to
+		 * override the default ones for this type */
+		php_phongo_handle_field_path_entry_for_compound_type(&state, &state.map.document_type, &state.map.document);
 
-		array_init(&state.zchild);
+		/* Documents requested as BSON are copied without being visited, so
+		 * an ODM class in the document will not be considered. The include
+		 * and exclude type map elements only decide whether the document
+		 * itself is skipped, and do not filter its fields. */
+		if (state.map.document_type == PHONGO_TYPEMAP_BSON) {
+			zval zchild;
 
-		if (!bson_iter_visit_all(&child, &php_bson_visitors, &state) && !child.err_off) {
-			/* Check for entries in the fieldPath type map key, and use them to
-			 * override the default ones for this type */
-			php_phongo_handle_field_path_entry_for_compound_type(&state, &state.map.document_type, &state.map.document);
+			phongo_document_new(&zchild, v_document);
+			php_phongo_bson_state_add_zval(parent_state, key, &zchild);
 
+			php_phongo_bson_state_dtor(&state);
+			php_phongo_bson_state_pop_field_path(parent_state);
+
+			return parent_state->hydrate && EG(exception);
+		}
+
+		if (php_phongo_bson_is_hydrated_class(state.map.document_type, state.map.document)) {
+			php_phongo_bson_state_init_hydrate(&state, state.map.document);
+		} else {
+			php_phongo_bson_state_init_document(&state, v_document, state.map.document_type);
+		}
+
+		if (!bson_iter_visit_all(&child, &php_bson_visitors, &state) && !child.err_off && !(state.hydrate && EG(exception))) {
 			/* If php_phongo_bson_visit_binary() finds an ODM class, it should
 			 * supersede a default type map and named document class. */
 			if (state.odm && state.map.document_type == PHONGO_TYPEMAP_NONE) {
@@ -797,35 +1071,34 @@ static bool php_phongo_bson_visit_document(const bson_iter_t* iter ARG_UNUSED, c
 
 			switch (state.map.document_type) {
 				case PHONGO_TYPEMAP_NATIVE_ARRAY:
-					if (((php_phongo_bson_state*) data)->is_visiting_array) {
-						add_next_index_zval(retval, &state.zchild);
-					} else {
-						ADD_ASSOC_ZVAL(retval, key, &state.zchild);
-					}
+					php_phongo_bson_state_add_zval(parent_state, key, &state.zchild);
 					break;
 
 				case PHONGO_TYPEMAP_CLASS: {
 					zval obj;
 
+					/* A hydrated object ignores any ODM class, since it was
+					 * created before its fields were visited. */
+					if (state.hydrate) {
+						php_phongo_bson_state_add_zval(parent_state, key, &state.zchild);
+						break;
+					}
+
+					if (state.is_visiting_object) {
+						php_phongo_bson_state_zchild_to_array(&state.zchild);
+					}
+
 					object_init_ex(&obj, state.odm ? state.odm : state.map.document);
 					zend_call_method_with_1_params(PHONGO_COMPAT_OBJ_P(&obj), NULL, NULL, BSON_UNSERIALIZE_FUNC_NAME, NULL, &state.zchild);
-					if (((php_phongo_bson_state*) data)->is_visiting_array) {
-						add_next_index_zval(retval, &obj);
-					} else {
-						ADD_ASSOC_ZVAL(retval, key, &obj);
-					}
+					php_phongo_bson_state_add_zval(parent_state, key, &obj);
 					zval_ptr_dtor(&state.zchild);
 					break;
 				}
 
 				case PHONGO_TYPEMAP_NATIVE_OBJECT:
 				default:
-					convert_to_object(&state.zchild);
-					if (((php_phongo_bson_state*) data)->is_visiting_array) {
-						add_next_index_zval(retval, &state.zchild);
-					} else {
-						ADD_ASSOC_ZVAL(retval, key, &state.zchild);
-					}
+					php_phongo_bson_state_zchild_to_object(&state.zchild);
+					php_phongo_bson_state_add_zval(parent_state, key, &state.zchild);
 			}
 		} else {
 			/* Iteration stopped prematurely due to corruption or a failed
@@ -837,25 +1110,31 @@ static bool php_phongo_bson_visit_document(const bson_iter_t* iter ARG_UNUSED, c
 		}
 
 		php_phongo_bson_state_dtor(&state);
-		php_phongo_field_path_pop(parent_state->field_path);
+		php_phongo_bson_state_pop_field_path(parent_state);
 	}
 
-	return false;
+	/* Stop iterating if a hydrated parent object rejected the value */
+	return parent_state->hydrate && EG(exception);
 } /* }}} */
 
 static bool php_phongo_bson_visit_array(const bson_iter_t* iter ARG_UNUSED, const char* key, const bson_t* v_array, void* data) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	bson_iter_t            child;
-	php_phongo_bson_state* parent_state = (php_phongo_bson_state*) data;
+	bson_iter_t                 child;
+	php_phongo_bson_state*      parent_state = (php_phongo_bson_state*) data;
+	php_phongo_field_path_node* filter_node;
 
-	php_phongo_field_path_push(parent_state->field_path, key, PHONGO_FIELD_PATH_ITEM_ARRAY);
+	if (php_phongo_bson_state_skip_field(parent_state, key, &filter_node)) {
+		return false;
+	}
+
+	php_phongo_bson_state_push_field_path(parent_state, key, PHONGO_FIELD_PATH_ITEM_ARRAY);
 
 	if (bson_iter_init(&child, v_array)) {
 		php_phongo_bson_state state;
 
 		PHONGO_BSON_INIT_STATE(state);
 		php_phongo_bson_state_copy_ctor(&state, parent_state);
+		state.filter_node = filter_node;
 
 		/* Note that we are visiting an array, so element visitors know to use
 		 * add_next_index() (i.e. disregard BSON keys) instead of add_assoc()
@@ -863,44 +1142,55 @@ static bool php_phongo_bson_visit_array(const bson_iter_t* iter ARG_UNUSED, cons
 		 */
 		state.is_visiting_array = true;
 
-		array_init(&state.zchild);
+		/* Check for entries in the fieldPath type map key, and use them to
+		 * override the default ones for this type */
+		php_phongo_handle_field_path_entry_for_compound_type(&state, &state.map.array_type, &state.map.array);
+
+		/* As with documents, arrays requested as BSON are copied without
+		 * filtering their elements */
+		if (state.map.array_type == PHONGO_TYPEMAP_BSON) {
+			zval zchild;
 
-		if (!bson_iter_visit_all(&child, &php_bson_visitors, &state) && !child.err_off) {
-			/* Check for entries in the fieldPath type map key, and use them to
-			 * override the default ones for this type */
-			php_phongo_handle_field_path_entry_for_compound_type(&state, &state.map.array_type, &state.map.array);
+			phongo_packedarray_new(&zchild, v_array);
+			php_phongo_bson_state_add_zval(parent_state, key, &zchild);
 
+			php_phongo_bson_state_dtor(&state);
+			php_phongo_bson_state_pop_field_path(parent_state);
+
+			return parent_state->hydrate && EG(exception);
+		}
+
+		if (php_phongo_bson_is_hydrated_class(state.map.array_type, state.map.array)) {
+			php_phongo_bson_state_init_hydrate(&state, state.map.array);
+		} else {
+			array_init(&state.zchild);
+		}
+
+		if (!bson_iter_visit_all(&child, &php_bson_visitors, &state) && !child.err_off && !(state.hydrate && EG(exception))) {
 			switch (state.map.array_type) {
 				case PHONGO_TYPEMAP_CLASS: {
 					zval obj;
 
+					if (state.hydrate) {
+						php_phongo_bson_state_add_zval(parent_state, key, &state.zchild);
+						break;
+					}
+
 					object_init_ex(&obj, state.map.array);
 					zend_call_method_with_1_params(PHONGO_COMPAT_OBJ_P(&obj), NULL, NULL, BSON_UNSERIALIZE_FUNC_NAME, NULL, &state.zchild);
-					if (((php_phongo_bson_state*) data)->is_visiting_array) {
-						add_next_index_zval(retval, &obj);
-					} else {
-						ADD_ASSOC_ZVAL(retval, key, &obj);
-					}
+					php_phongo_bson_state_add_zval(parent_state, key, &obj);
 					zval_ptr_dtor(&state.zchild);
 					break;
 				}
 
 				case PHONGO_TYPEMAP_NATIVE_OBJECT:
 					convert_to_object(&state.zchild);
-					if (((php_phongo_bson_state*) data)->is_visiting_array) {
-						add_next_index_zval(retval, &state.zchild);
-					} else {
-						ADD_ASSOC_ZVAL(retval, key, &state.zchild);
-					}
+					php_phongo_bson_state_add_zval(parent_state, key, &state.zchild);
 					break;
 
 				case PHONGO_TYPEMAP_NATIVE_ARRAY:
 				default:
-					if (((php_phongo_bson_state*) data)->is_visiting_array) {
-						add_next_index_zval(retval, &state.zchild);
-					} else {
-						ADD_ASSOC_ZVAL(retval, key, &state.zchild);
-					}
+					php_phongo_bson_state_add_zval(parent_state, key, &state.zchild);
 					break;
 			}
 		} else {
@@ -913,12 +1203,118 @@ static bool php_phongo_bson_visit_array(const bson_iter_t* iter ARG_UNUSED, cons
 		}
 
 		php_phongo_bson_state_dtor(&state);
-		php_phongo_field_path_pop(parent_state->field_path);
+		php_phongo_bson_state_pop_field_path(parent_state);
+	}
+
+	/* Stop iterating if a hydrated parent object rejected the value */
+	return parent_state->hydrate && EG(exception);
+} /* }}} */
+
+static bool php_phongo_bson_path_visit_before(const bson_iter_t* iter ARG_UNUSED, const char* key, void* data) /* {{{ */
+{
+	php_phongo_field_path_write_item_at_current_level((php_phongo_field_path*) data, key);
+
+	return false;
+} /* }}} */
+
+static bool php_phongo_bson_path_visit_compound(const char* key, const bson_t* v_compound, php_phongo_bson_field_path_item_types type, php_phongo_field_path* field_path) /* {{{ */
+{
+	bson_iter_t child;
+
+	php_phongo_field_path_push(field_path, key, type);
+
+	if (bson_iter_init(&child, v_compound)) {
+		if (bson_iter_visit_all(&child, &php_bson_path_visitors, field_path) || child.err_off) {
+			/* Leave the field path pointing at the failed field */
+			return true;
+		}
 	}
 
+	php_phongo_field_path_pop(field_path);
+
 	return false;
 } /* }}} */
 
+static bool php_phongo_bson_path_visit_document(const bson_iter_t* iter ARG_UNUSED, const char* key, const bson_t* v_document, void* data) /* {{{ */
+{
+	return php_phongo_bson_path_visit_compound(key, v_document, PHONGO_FIELD_PATH_ITEM_DOCUMENT, (php_phongo_field_path*) data);
+} /* }}} */
+
+static bool php_phongo_bson_path_visit_array(const bson_iter_t* iter ARG_UNUSED, const char* key, const bson_t* v_array, void* data) /* {{{ */
+{
+	return php_phongo_bson_path_visit_compound(key, v_array, PHONGO_FIELD_PATH_ITEM_ARRAY, (php_phongo_field_path*) data);
+} /* }}} */
+
+static void php_phongo_bson_path_visit_unsupported_type(const bson_iter_t* iter ARG_UNUSED, const char* key, uint32_t v_type_code, void* data) /* {{{ */
+{
+	php_phongo_field_path* field_path = (php_phongo_field_path*) data;
+	char*                  path_string;
+
+	php_phongo_field_path_write_item_at_current_level(field_path, key);
+	path_string = php_phongo_field_path_as_string(field_path);
+
+	phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE, "Detected unknown BSON type 0x%02hhx for field path \"%s\". Are you using the latest driver?", (unsigned char) v_type_code, path_string);
+
+	efree(path_string);
+} /* }}} */
+
+/* Visitors that only track the field path, which are used to walk a document
+ * again after decoding it failed. Field names are recorded before each field
+ * is visited, and the walk stops at the same field as the decoding did. */
+static const bson_visitor_t php_bson_path_visitors = {
+	php_phongo_bson_path_visit_before,
+	NULL /* visit_after */,
+	NULL /* visit_corrupt */,
+	NULL /* visit_double */,
+	NULL /* visit_utf8 */,
+	php_phongo_bson_path_visit_document,
+	php_phongo_bson_path_visit_array,
+	NULL /* visit_binary */,
+	NULL /* visit_undefined */,
+	NULL /* visit_oid */,
+	NULL /* visit_bool */,
+	NULL /* visit_date_time */,
+	NULL /* visit_null */,
+	NULL /* visit_regex */,
+	NULL /* visit_dbpointer */,
+	NULL /* visit_code */,
+	NULL /* visit_symbol */,
+	NULL /* visit_codewscope */,
+	NULL /* visit_int32 */,
+	NULL /* visit_timestamp */,
+	NULL /* visit_int64 */,
+	NULL /* visit_maxkey */,
+	NULL /* visit_minkey */,
+	php_phongo_bson_path_visit_unsupported_type,
+	NULL /* visit_decimal128 */,
+	{ NULL }
+};
+
+/* Throws an exception for a document that could not be decoded due to corrupt
+ * data or an unsupported BSON type. Since field paths are not tracked while
+ * decoding, the document is walked again up to the failed field in order to
+ * report its path. The error offset of the decoding is used if the walk does
+ * not encounter the error. */
+static void php_phongo_bson_throw_visit_error(const bson_t* b, uint32_t err_off) /* {{{ */
+{
+	bson_iter_t            iter;
+	php_phongo_field_path* field_path = php_phongo_field_path_alloc(false);
+	char*                  path;
+
+	if (bson_iter_init(&iter, b) && (bson_iter_visit_all(&iter, &php_bson_path_visitors, field_path) || iter.err_off)) {
+		err_off = iter.err_off;
+	}
+
+	/* The unsupported type visitor already threw an exception */
+	if (!EG(exception)) {
+		path = php_phongo_field_path_as_string(field_path);
+		phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE, "Detected corrupt BSON data for field path '%s' at offset %d", path, err_off);
+		efree(path);
+	}
+
+	php_phongo_field_path_free(field_path);
+} /* }}} */
+
 /* Converts a BSON document to a PHP value using the default typemap. */
 bool php_phongo_bson_to_zval(const unsigned char* data, int data_len, zval* zv) /* {{{ */
 {
@@ -945,7 +1341,7 @@ bool php_phongo_bson_value_to_zval(const bson_value_t* value, zval* zv) /* {{{ *
 	state.map.root_type = PHONGO_TYPEMAP_NATIVE_ARRAY;
 
 	bson_append_value(&bson, "data", 4, value);
-	if (!php_phongo_bson_to_zval_ex(bson_get_data(&bson), bson.len, &state)) {
+	if (!php_phongo_bson_doc_to_zval_ex(&bson, &state)) {
 		/* Exception already thrown */
 		goto cleanup;
 	}
@@ -963,64 +1359,76 @@ cleanup:
 	return retval;
 } /* }}} */
 
-/* Converts a BSON document to a PHP value according to the typemap specified in
- * the state argument.
- *
- * On success, the result will be set on the state argument and true will be
- * returned. On error, an exception will have been thrown and false will be
- * returned.
- *
- * Note: the result zval in the state argument will always be initialized for
- * PHP 5.x so that the caller may always zval_ptr_dtor() it. The zval is left
- * as-is on PHP 7; however, it should have the type undefined if the state
- * was initialized to zero.
- */
-bool php_phongo_bson_to_zval_ex(const unsigned char* data, int data_len, php_phongo_bson_state* state) /* {{{ */
+/* Converts the value at the iterator's current position to a ZVAL. Embedded
+ * documents and arrays are returned as Document and PackedArray objects, which
+ * are only decoded when accessed. */
+bool php_phongo_bson_iter_to_zval(const bson_iter_t* iter, zval* zv) /* {{{ */
 {
-	bson_reader_t* reader = NULL;
-	bson_iter_t    iter;
-	const bson_t*  b;
-	bool           eof             = false;
-	bool           retval          = false;
-	bool           must_dtor_state = false;
+	const uint8_t* data;
+	uint32_t       data_len;
+	bson_t         bson;
+
+	switch (bson_iter_type(iter)) {
+		case BSON_TYPE_DOCUMENT:
+		case BSON_TYPE_ARRAY:
+			if (BSON_ITER_HOLDS_DOCUMENT(iter)) {
+				bson_iter_document(iter, &data_len, &data);
+			} else {
+				bson_iter_array(iter, &data_len, &data);
+			}
 
-	if (!php_phongo_bson_state_is_initialized(state)) {
-		php_phongo_bson_state_ctor(state);
-		must_dtor_state = true;
-	}
+			if (!bson_init_static(&bson, data, data_len)) {
+				phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE, "Could not initialize BSON document");
+				return false;
+			}
 
-	reader = bson_reader_new_from_data(data, data_len);
+			if (BSON_ITER_HOLDS_DOCUMENT(iter)) {
+				phongo_document_new(zv, &bson);
+			} else {
+				phongo_packedarray_new(zv, &bson);
+			}
 
-	if (!(b = bson_reader_read(reader, NULL))) {
-		phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE, "Could not read document from BSON reader");
+			return true;
 
-		goto cleanup;
+		default:
+			return php_phongo_bson_value_to_zval(bson_iter_value((bson_iter_t*) iter), zv);
 	}
+} /* }}} */
+
+/* Visits the fields of a root document and applies the root type map. On
+ * error, an exception will have been thrown and false will be returned. */
+static bool php_phongo_bson_visit_root(const bson_t* b, php_phongo_bson_state* state) /* {{{ */
+{
+	bson_iter_t iter;
 
 	if (!bson_iter_init(&iter, b)) {
 		phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE, "Could not initialize BSON iterator");
 
-		goto cleanup;
+		return false;
 	}
 
 	/* We initialize an array because it will either be returned as-is (native
-	 * array in type map), passed to bsonUnserialize() (ODM class), or used to
-	 * initialize a stdClass object (native object in type map). */
-	array_init(&state->zchild);
+	 * array in type map), passed to bsonUnserialize() (ODM class), or used as
+	 * the property table of a stdClass object (native object in type map). */
+	if (php_phongo_bson_is_hydrated_class(state->map.root_type, state->map.root)) {
+		php_phongo_bson_state_init_hydrate(state, state->map.root);
+	} else {
+		php_phongo_bson_state_init_document(state, b, state->map.root_type);
+	}
 
-	if (bson_iter_visit_all(&iter, &php_bson_visitors, state) || iter.err_off) {
+	state->filter_node = state->map.field_filter ? &state->map.field_filter->root : NULL;
+
+	if (bson_iter_visit_all(&iter, &php_bson_visitors, state) || iter.err_off || (state->hydrate && EG(exception))) {
 		/* Iteration stopped prematurely due to corruption or a failed visitor.
-		 * While we free the reader, state->zchild should be left as-is, since
-		 * the calling code may want to zval_ptr_dtor() it. If an exception has
+		 * state->zchild should be left as-is, since the calling code may want
+		 * to zval_ptr_dtor() it. If an exception has
 		 * been thrown already (due to an unsupported BSON type for example,
 		 * don't overwrite with a generic exception message. */
 		if (!EG(exception)) {
-			char* path = php_phongo_field_path_as_string(state->field_path);
-			phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE, "Detected corrupt BSON data for field path '%s' at offset %d", path, iter.err_off);
-			efree(path);
+			php_phongo_bson_throw_visit_error(b, iter.err_off);
 		}
 
-		goto cleanup;
+		return false;
 	}
 
 	/* If php_phongo_bson_visit_binary() finds an ODM class, it should supersede
@@ -1037,6 +1445,14 @@ bool php_phongo_bson_to_zval_ex(const unsigned char* data, int data_len, php_pho
 		case PHONGO_TYPEMAP_CLASS: {
 			zval obj;
 
+			if (state->hydrate) {
+				break;
+			}
+
+			if (state->is_visiting_object) {
+				php_phongo_bson_state_zchild_to_array(&state->zchild);
+			}
+
 			object_init_ex(&obj, state->odm ? state->odm : state->map.root);
 			zend_call_method_with_1_params(PHONGO_COMPAT_OBJ_P(&obj), NULL, NULL, BSON_UNSERIALIZE_FUNC_NAME, NULL, &state->zchild);
 			zval_ptr_dtor(&state->zchild);
@@ -1047,21 +1463,65 @@ bool php_phongo_bson_to_zval_ex(const unsigned char* data, int data_len, php_pho
 
 		case PHONGO_TYPEMAP_NATIVE_OBJECT:
 		default:
-			convert_to_object(&state->zchild);
+			php_phongo_bson_state_zchild_to_object(&state->zchild);
 	}
 
-	if (bson_reader_read(reader, &eof) || !eof) {
-		phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE, "Reading document did not exhaust input buffer");
+	return true;
+} /* }}} */
 
-		goto cleanup;
+/* Initializes a static bson_t for the document at the start of the buffer,
+ * which must outlive the bson_t. Unlike bson_reader_t, this requires no
+ * allocation. Returns false if the buffer does not begin with a valid document.
+ * The caller may compare the document's length with data_len to check whether
+ * it exhausted the buffer. */
+bool php_phongo_bson_init_static_from_data(bson_t* bson, const unsigned char* data, size_t data_len) /* {{{ */
+{
+	uint32_t len_le;
+	uint32_t len;
+
+	if (data_len < 5) {
+		return false;
 	}
 
-	retval = true;
+	memcpy(&len_le, data, sizeof(len_le));
+	len = BSON_UINT32_FROM_LE(len_le);
 
-cleanup:
-	if (reader) {
-		bson_reader_destroy(reader);
+	if (len < 5 || len > data_len) {
+		return false;
+	}
+
+	return bson_init_static(bson, data, len);
+} /* }}} */
+
+/* Converts a BSON document to a PHP value using the state's type map. Callers
+ * that already have a bson_t (e.g. from mongoc_cursor_next()) should use this
+ * instead of php_phongo_bson_to_zval_ex(). */
+bool php_phongo_bson_doc_to_zval_ex(const bson_t* b, php_phongo_bson_state* state) /* {{{ */
+{
+	bool retval          = true;
+	bool must_dtor_state = false;
+
+	if (!php_phongo_bson_state_is_initialized(state) && state->map.field_paths) {
+		php_phongo_bson_state_ctor(state);
+		must_dtor_state = true;
+	}
+
+	PHONGO_PROBE1(bson__decode__start, b->len);
+
+	if (state->map.root_type == PHONGO_TYPEMAP_BSON) {
+		/* The document is returned as-is without visiting its fields, so
+		 * the include and exclude type map elements do not apply */
+		phongo_document_new(&state->zchild, b);
+	} else if (state->map.root_type == PHONGO_TYPEMAP_RAW) {
+		/* The BSON bytes are returned as a string, e.g. to be passed through
+		 * to another consumer without a decode and encode round trip */
+		ZVAL_STRINGL(&state->zchild, (const char*) bson_get_data(b), b->len);
+	} else {
+		retval = php_phongo_bson_visit_root(b, state);
 	}
+
+	PHONGO_PROBE1(bson__decode__done, retval);
+
 	if (must_dtor_state) {
 		php_phongo_bson_state_dtor(state);
 	}
@@ -1069,6 +1529,39 @@ cleanup:
 	return retval;
 } /* }}} */
 
+/* Converts a BSON document to a PHP value according to the typemap specified in
+ * the state argument.
+ *
+ * On success, the result will be set on the state argument and true will be
+ * returned. On error, an exception will have been thrown and false will be
+ * returned.
+ *
+ * Note: the result zval in the state argument will always be initialized for
+ * PHP 5.x so that the caller may always zval_ptr_dtor() it. The zval is left
+ * as-is on PHP 7; however, it should have the type undefined if the state
+ * was initialized to zero.
+ */
+bool php_phongo_bson_to_zval_ex(const unsigned char* data, int data_len, php_phongo_bson_state* state) /* {{{ */
+{
+	bson_t b;
+
+	if (data_len < 0 || !php_phongo_bson_init_static_from_data(&b, data, (size_t) data_len)) {
+		phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE, "Could not read document from BSON reader");
+		return false;
+	}
+
+	if (!php_phongo_bson_doc_to_zval_ex(&b, state)) {
+		return false;
+	}
+
+	if (b.len != (uint32_t) data_len) {
+		phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE, "Reading document did not exhaust input buffer");
+		return false;
+	}
+
+	return true;
+} /* }}} */
+
 /* Fetches a zend_class_entry for the given class name and checks that it is
  * also instantiatable and implements a specified interface. Returns the class
  * on success; otherwise, NULL is returned and an exception is thrown. */
@@ -1082,7 +1575,9 @@ static zend_class_entry* php_phongo_bson_state_fetch_class(const char* classname
 		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "Class %s does not exist", classname);
 	} else if (!PHONGO_IS_CLASS_INSTANTIATABLE(found_ce)) {
 		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "Class %s is not instantiatable", classname);
-	} else if (!instanceof_function(found_ce, interface_ce)) {
+	} else if (!instanceof_function(found_ce, interface_ce) && !instanceof_function(found_ce, php_phongo_propertycodec_ce)) {
+		/* Classes implementing MongoDB\BSON\PropertyCodec are hydrated
+		 * directly (see php_phongo_bson_is_hydrated_class()) */
 		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "Class %s does not implement %s", classname, ZSTR_VAL(interface_ce->name));
 	} else {
 		return found_ce;
@@ -1113,6 +1608,12 @@ static bool php_phongo_bson_state_parse_type(zval* options, const char* name, ph
 	} else if (!strcasecmp(classname, "stdclass") || !strcasecmp(classname, "object")) {
 		*type    = PHONGO_TYPEMAP_NATIVE_OBJECT;
 		*type_ce = NULL;
+	} else if (!strcasecmp(classname, "bson")) {
+		*type    = PHONGO_TYPEMAP_BSON;
+		*type_ce = NULL;
+	} else if (!strcasecmp(classname, "raw")) {
+		*type    = PHONGO_TYPEMAP_RAW;
+		*type_ce = NULL;
 	} else {
 		if ((*type_ce = php_phongo_bson_state_fetch_class(classname, classname_len, php_phongo_unserializable_ce))) {
 			*type = PHONGO_TYPEMAP_CLASS;
@@ -1129,98 +1630,169 @@ cleanup:
 	return retval;
 } /* }}} */
 
-static void field_path_map_element_set_info(php_phongo_field_path_map_element* element, php_phongo_bson_typemap_types type, zend_class_entry* ce)
+static void php_phongo_field_path_node_dtor(php_phongo_field_path_node* node)
 {
-	element->node_type = type;
-	element->node_ce   = ce;
+	if (node->children) {
+		zend_hash_destroy(node->children);
+		FREE_HASHTABLE(node->children);
+	}
+	if (node->wildcard) {
+		php_phongo_field_path_node_dtor(node->wildcard);
+		efree(node->wildcard);
+	}
 }
 
-static void map_add_field_path_element(php_phongo_bson_typemap* map, php_phongo_field_path_map_element* element)
+static void php_phongo_field_path_node_free_zval(zval* zv)
 {
-	/* Make sure we have allocated enough */
-	if (map->field_paths.allocated_size < map->field_paths.size + 1) {
-		map->field_paths.allocated_size += PHONGO_FIELD_PATH_EXPANSION;
-		map->field_paths.map = erealloc(map->field_paths.map, sizeof(php_phongo_field_path_map_element) * map->field_paths.allocated_size);
+	php_phongo_field_path_node* node = Z_PTR_P(zv);
+
+	php_phongo_field_path_node_dtor(node);
+	efree(node);
+}
+
+/* Returns the child node for a path segment, creating it if necessary */
+static php_phongo_field_path_node* php_phongo_field_path_node_get_child(php_phongo_field_path_node* node, const char* segment, size_t segment_len)
+{
+	php_phongo_field_path_node* child;
+
+	if (segment_len == 1 && segment[0] == '$') {
+		if (!node->wildcard) {
+			node->wildcard = ecalloc(1, sizeof(php_phongo_field_path_node));
+		}
+
+		return node->wildcard;
+	}
+
+	if (!node->children) {
+		ALLOC_HASHTABLE(node->children);
+		zend_hash_init(node->children, 0, NULL, php_phongo_field_path_node_free_zval, 0);
+	}
+
+	if ((child = zend_hash_str_find_ptr(node->children, segment, segment_len))) {
+		return child;
 	}
 
-	map->field_paths.map[map->field_paths.size] = element;
-	map->field_paths.size++;
+	child = ecalloc(1, sizeof(php_phongo_field_path_node));
+	zend_hash_str_add_new_ptr(node->children, segment, segment_len, child);
+
+	return child;
 }
 
-static php_phongo_field_path_map_element* field_path_map_element_alloc(void)
+/* Merges the paths of one node into another. Field path orders are not
+ * compared, since the include and exclude filters only consider whether a node
+ * terminates a path. */
+static void php_phongo_field_path_node_merge(php_phongo_field_path_node* dst, php_phongo_field_path_node* src)
 {
-	php_phongo_field_path_map_element* tmp = ecalloc(1, sizeof(php_phongo_field_path_map_element));
+	zend_string*                key;
+	php_phongo_field_path_node* child;
 
-	tmp->entry = php_phongo_field_path_alloc(true);
+	if (src->order && !dst->order) {
+		dst->order = src->order;
+	}
 
-	return tmp;
+	if (src->children) {
+		ZEND_HASH_FOREACH_STR_KEY_PTR(src->children, key, child)
+		{
+			php_phongo_field_path_node_merge(php_phongo_field_path_node_get_child(dst, ZSTR_VAL(key), ZSTR_LEN(key)), child);
+		}
+		ZEND_HASH_FOREACH_END();
+	}
+
+	if (src->wildcard) {
+		php_phongo_field_path_node_merge(php_phongo_field_path_node_get_child(dst, "$", 1), src->wildcard);
+	}
 }
 
-static void field_path_map_element_dtor(php_phongo_field_path_map_element* element)
+/* Merges the wildcard branch of each node into its exact children. A field that
+ * matches an exact segment then only needs to follow that segment's branch,
+ * which lets the include and exclude filters track a single node per level. */
+static void php_phongo_field_path_node_merge_wildcards(php_phongo_field_path_node* node)
 {
-	php_phongo_field_path_free(element->entry);
-	efree(element);
+	php_phongo_field_path_node* child;
+
+	if (node->children) {
+		ZEND_HASH_FOREACH_PTR(node->children, child)
+		{
+			if (node->wildcard) {
+				php_phongo_field_path_node_merge(child, node->wildcard);
+			}
+
+			php_phongo_field_path_node_merge_wildcards(child);
+		}
+		ZEND_HASH_FOREACH_END();
+	}
+
+	if (node->wildcard) {
+		php_phongo_field_path_node_merge_wildcards(node->wildcard);
+	}
 }
 
-static bool php_phongo_bson_state_add_field_path(php_phongo_bson_typemap* map, char* field_path_original, php_phongo_bson_typemap_types type, zend_class_entry* ce)
+/* Compiles a dotted field path into the trie, allocating the map if necessary.
+ * The description is used as the subject of exception messages. */
+static bool php_phongo_field_path_map_add(php_phongo_field_path_map** map, const char* field_path_original, const char* description, php_phongo_bson_typemap_types type, zend_class_entry* ce)
 {
-	char*                              ptr         = NULL;
-	char*                              segment_end = NULL;
-	php_phongo_field_path_map_element* field_path_map_element;
+	const char*                 ptr         = NULL;
+	const char*                 segment_end = NULL;
+	php_phongo_field_path_node* node;
 
 	if (field_path_original[0] == '.') {
-		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "A 'fieldPaths' key may not start with a '.'");
+		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "%s may not start with a '.'", description);
 		return false;
 	}
 
 	if (field_path_original[strlen(field_path_original) - 1] == '.') {
-		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "A 'fieldPaths' key may not end with a '.'");
+		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "%s may not end with a '.'", description);
 		return false;
 	}
 
-	field_path_map_element = field_path_map_element_alloc();
-	ptr                    = field_path_original;
-
-	/* Loop over all the segments. A segment is delimited by a "." */
-	while ((segment_end = strchr(ptr, '.')) != NULL) {
-		char* tmp = NULL;
+	/* Bail out before modifying the map if we have an empty segment */
+	if (strstr(field_path_original, "..")) {
+		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "%s may not have an empty segment", description);
+		return false;
+	}
 
-		/* Bail out if we have an empty segment */
-		if (ptr == segment_end) {
-			field_path_map_element_dtor(field_path_map_element);
-			phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "A 'fieldPaths' key may not have an empty segment");
-			return false;
-		}
+	if (!*map) {
+		*map              = ecalloc(1, sizeof(php_phongo_field_path_map));
+		(*map)->ref_count = 1;
+	}
 
-		tmp = calloc(1, segment_end - ptr + 1);
-		memcpy(tmp, ptr, segment_end - ptr);
-		php_phongo_field_path_push(field_path_map_element->entry, tmp, PHONGO_FIELD_PATH_ITEM_NONE);
-		free(tmp);
+	node = &(*map)->root;
+	ptr  = field_path_original;
 
-		ptr = segment_end + 1;
+	/* Loop over all the segments. A segment is delimited by a "." */
+	while ((segment_end = strchr(ptr, '.')) != NULL) {
+		node = php_phongo_field_path_node_get_child(node, ptr, segment_end - ptr);
+		ptr  = segment_end + 1;
 	}
 
 	/* Add the last (or single) element */
-	php_phongo_field_path_push(field_path_map_element->entry, ptr, PHONGO_FIELD_PATH_ITEM_NONE);
+	node = php_phongo_field_path_node_get_child(node, ptr, strlen(ptr));
 
-	field_path_map_element_set_info(field_path_map_element, type, ce);
-	map_add_field_path_element(map, field_path_map_element);
+	/* If the same path was already added, the earlier entry takes precedence */
+	if (!node->order) {
+		node->node_type = type;
+		node->node_ce   = ce;
+		node->order     = ++(*map)->size;
+	}
 
 	return true;
 }
 
-void php_phongo_bson_typemap_dtor(php_phongo_bson_typemap* map)
+static void php_phongo_field_path_map_release(php_phongo_field_path_map* map)
 {
-	size_t i;
-
-	if (map->field_paths.map) {
-		for (i = 0; i < map->field_paths.size; i++) {
-			field_path_map_element_dtor(map->field_paths.map[i]);
-		}
-		efree(map->field_paths.map);
+	if (map && --map->ref_count == 0) {
+		php_phongo_field_path_node_dtor(&map->root);
+		efree(map);
 	}
+}
 
-	map->field_paths.map = NULL;
+void php_phongo_bson_typemap_dtor(php_phongo_bson_typemap* map)
+{
+	php_phongo_field_path_map_release(map->field_paths);
+	php_phongo_field_path_map_release(map->field_filter);
+
+	map->field_paths  = NULL;
+	map->field_filter = NULL;
 }
 
 /* Loops over each element in the fieldPaths array (if exists, and is an
@@ -1250,8 +1822,8 @@ static bool php_phongo_bson_state_parse_fieldpaths(zval* typemap, php_phongo_bso
 
 		ZEND_HASH_FOREACH_KEY_VAL(ht_data, num_key, string_key, property)
 		{
-			zend_class_entry*             map_ce = NULL;
-			php_phongo_bson_typemap_types map_type;
+			zend_class_entry*             map_ce   = NULL;
+			php_phongo_bson_typemap_types map_type = PHONGO_TYPEMAP_NONE;
 
 			if (!string_key) {
 				phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "The 'fieldPaths' element is not an associative array");
@@ -1267,7 +1839,12 @@ static bool php_phongo_bson_state_parse_fieldpaths(zval* typemap, php_phongo_bso
 				return false;
 			}
 
-			if (!php_phongo_bson_state_add_field_path(map, ZSTR_VAL(string_key), map_type, map_ce)) {
+			if (map_type == PHONGO_TYPEMAP_RAW) {
+				phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "The 'raw' type may only be used for the 'root' element");
+				return false;
+			}
+
+			if (!php_phongo_field_path_map_add(&map->field_paths, ZSTR_VAL(string_key), "A 'fieldPaths' key", map_type, map_ce)) {
 				return false;
 			}
 		}
@@ -1277,23 +1854,234 @@ static bool php_phongo_bson_state_parse_fieldpaths(zval* typemap, php_phongo_bso
 	return true;
 } /* }}} */
 
-/* Applies the array argument to a typemap struct. Returns true on success;
- * otherwise, false is returned an an exception is thrown. */
-bool php_phongo_bson_typemap_to_state(zval* typemap, php_phongo_bson_typemap* map) /* {{{ */
+/* Parses the include or exclude element of the type map, which is a list of
+ * dotted field paths. Only one of the two elements may be specified. Fields
+ * that are filtered out are skipped while decoding and never converted. */
+static bool php_phongo_bson_state_parse_field_filter(zval* typemap, php_phongo_bson_typemap* map) /* {{{ */
 {
-	if (!typemap) {
+	const char* name        = NULL;
+	const char* description = NULL;
+	zval*       paths       = NULL;
+	zval*       path;
+
+	if (php_array_existsc(typemap, "include")) {
+		if (php_array_existsc(typemap, "exclude")) {
+			phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "The 'include' and 'exclude' elements cannot both be specified");
+			return false;
+		}
+
+		name        = "include";
+		description = "An 'include' path";
+	} else if (php_array_existsc(typemap, "exclude")) {
+		name                      = "exclude";
+		description               = "An 'exclude' path";
+		map->field_filter_exclude = true;
+	} else {
+		return true;
+	}
+
+	paths = php_array_fetch_array(typemap, name);
+
+	if (!paths) {
+		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "The '%s' element is not an array", name);
+		return false;
+	}
+
+	/* Allocate the map up front, so that an empty include list filters out
+	 * all fields rather than being ignored */
+	map->field_filter            = ecalloc(1, sizeof(php_phongo_field_path_map));
+	map->field_filter->ref_count = 1;
+
+	ZEND_HASH_FOREACH_VAL(HASH_OF(paths), path)
+	{
+		ZVAL_DEREF(path);
+
+		if (Z_TYPE_P(path) != IS_STRING) {
+			phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "The '%s' element must contain only strings", name);
+			return false;
+		}
+
+		if (Z_STRLEN_P(path) == 0) {
+			phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "The '%s' element may not contain an empty string", name);
+			return false;
+		}
+
+		if (!php_phongo_field_path_map_add(&map->field_filter, Z_STRVAL_P(path), description, PHONGO_TYPEMAP_NONE, NULL)) {
+			return false;
+		}
+	}
+	ZEND_HASH_FOREACH_END();
+
+	php_phongo_field_path_node_merge_wildcards(&map->field_filter->root);
+
+	return true;
+} /* }}} */
+
+/* Parses the "types" element, which maps BSON value types to PHP scalars. Each
+ * BSON type may only be mapped to the scalar that represents its value without
+ * loss (e.g. the hex string of an ObjectId). */
+static bool php_phongo_bson_state_parse_scalar_types(zval* typemap, php_phongo_bson_typemap* map) /* {{{ */
+{
+	static const struct {
+		const char*                          name;
+		const char*                          target;
+		php_phongo_bson_typemap_scalar_types flag;
+	} scalar_types[] = {
+		{ "objectId", "string", PHONGO_TYPEMAP_SCALAR_OBJECTID },
+		{ "date", "int", PHONGO_TYPEMAP_SCALAR_DATE },
+		{ "decimal128", "string", PHONGO_TYPEMAP_SCALAR_DECIMAL128 },
+		{ "binary", "string", PHONGO_TYPEMAP_SCALAR_BINARY },
+	};
+
+	zval*        types;
+	zend_string* name;
+	zval*        target;
+
+	if (!php_array_existsc(typemap, "types")) {
 		return true;
 	}
 
+	types = php_array_fetch_array(typemap, "types");
+
+	if (!types) {
+		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "The 'types' element is not an array");
+		return false;
+	}
+
+	ZEND_HASH_FOREACH_STR_KEY_VAL(HASH_OF(types), name, target)
+	{
+		size_t i;
+
+		ZVAL_DEREF(target);
+
+		if (!name) {
+			phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "The 'types' element must be an associative array");
+			return false;
+		}
+
+		for (i = 0; i < sizeof(scalar_types) / sizeof(scalar_types[0]); i++) {
+			if (strcmp(ZSTR_VAL(name), scalar_types[i].name) == 0) {
+				break;
+			}
+		}
+
+		if (i == sizeof(scalar_types) / sizeof(scalar_types[0])) {
+			phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "The 'types' element contains an unsupported BSON type: '%s'", ZSTR_VAL(name));
+			return false;
+		}
+
+		if (Z_TYPE_P(target) != IS_STRING || strcasecmp(Z_STRVAL_P(target), scalar_types[i].target) != 0) {
+			phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "The '%s' type may only be mapped to '%s'", scalar_types[i].name, scalar_types[i].target);
+			return false;
+		}
+
+#if SIZEOF_ZEND_LONG == 4
+		/* Most dates are outside the range of a 32-bit integer, and would be
+		 * decoded as MongoDB\BSON\Int64 objects instead */
+		if (scalar_types[i].flag == PHONGO_TYPEMAP_SCALAR_DATE) {
+			phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "The 'date' type cannot be mapped to 'int' on 32-bit platforms");
+			return false;
+		}
+#endif
+
+		map->scalar_types |= scalar_types[i].flag;
+	}
+	ZEND_HASH_FOREACH_END();
+
+	return true;
+} /* }}} */
+
+/* Compiled type maps are cached for the duration of the request, keyed by the
+ * address of the type map array. Only immutable arrays (e.g. type map literals
+ * compiled by opcache) are cached: they outlive the request, so their address
+ * cannot be reused for a different array, and their contents cannot change. */
+typedef struct {
+	php_phongo_bson_typemap map;
+} php_phongo_bson_typemap_cache_entry;
+
+void php_phongo_bson_typemap_cache_dtor(zval* zv) /* {{{ */
+{
+	php_phongo_bson_typemap_cache_entry* entry = Z_PTR_P(zv);
+
+	php_phongo_bson_typemap_dtor(&entry->map);
+	efree(entry);
+} /* }}} */
+
+static void php_phongo_bson_typemap_copy(php_phongo_bson_typemap* dst, const php_phongo_bson_typemap* src) /* {{{ */
+{
+	*dst = *src;
+
+	if (dst->field_paths) {
+		dst->field_paths->ref_count++;
+	}
+
+	if (dst->field_filter) {
+		dst->field_filter->ref_count++;
+	}
+} /* }}} */
+
+static bool php_phongo_bson_typemap_parse(zval* typemap, php_phongo_bson_typemap* map) /* {{{ */
+{
 	if (!php_phongo_bson_state_parse_type(typemap, "array", &map->array_type, &map->array) ||
 		!php_phongo_bson_state_parse_type(typemap, "document", &map->document_type, &map->document) ||
 		!php_phongo_bson_state_parse_type(typemap, "root", &map->root_type, &map->root) ||
-		!php_phongo_bson_state_parse_fieldpaths(typemap, map)) {
+		!php_phongo_bson_state_parse_fieldpaths(typemap, map) ||
+		!php_phongo_bson_state_parse_field_filter(typemap, map) ||
+		!php_phongo_bson_state_parse_scalar_types(typemap, map)) {
 
 		/* Exception should already have been thrown */
+		php_phongo_bson_typemap_dtor(map);
 		return false;
 	}
 
+	/* Raw BSON strings cannot be told apart from string field values */
+	if (map->array_type == PHONGO_TYPEMAP_RAW || map->document_type == PHONGO_TYPEMAP_RAW) {
+		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "The 'raw' type may only be used for the 'root' element");
+		php_phongo_bson_typemap_dtor(map);
+		return false;
+	}
+
+	return true;
+} /* }}} */
+
+/* Applies the array argument to a typemap struct. Returns true on success;
+ * otherwise, false is returned an an exception is thrown.
+ *
+ * Immutable type map arrays are compiled once per request and reused for
+ * subsequent calls with the same array (e.g. a type map literal passed to
+ * toPHP() or Cursor::setTypeMap() in a loop). Mutable arrays are compiled on
+ * each call, since they may be modified in place or freed and their address
+ * reused. The typemap struct is expected to be zeroed and must be freed with
+ * php_phongo_bson_typemap_dtor(). */
+bool php_phongo_bson_typemap_to_state(zval* typemap, php_phongo_bson_typemap* map) /* {{{ */
+{
+	HashTable*                           cache = MONGODB_G(typemap_cache);
+	php_phongo_bson_typemap_cache_entry* entry;
+
+	if (!typemap) {
+		return true;
+	}
+
+	if (Z_TYPE_P(typemap) != IS_ARRAY || !(GC_FLAGS(Z_ARRVAL_P(typemap)) & IS_ARRAY_IMMUTABLE) || !cache) {
+		return php_phongo_bson_typemap_parse(typemap, map);
+	}
+
+	if ((entry = zend_hash_index_find_ptr(cache, (zend_ulong) (uintptr_t) Z_ARRVAL_P(typemap)))) {
+		php_phongo_bson_typemap_copy(map, &entry->map);
+		return true;
+	}
+
+	if (!php_phongo_bson_typemap_parse(typemap, map)) {
+		return false;
+	}
+
+	if (zend_hash_num_elements(cache) < PHONGO_TYPEMAP_CACHE_SIZE) {
+		entry = emalloc(sizeof(php_phongo_bson_typemap_cache_entry));
+		php_phongo_bson_typemap_copy(&entry->map, map);
+
+		zend_hash_index_add_new_ptr(cache, (zend_ulong) (uintptr_t) Z_ARRVAL_P(typemap), entry);
+	}
+
 	return true;
 } /* }}} */
 
@@ -44,14 +44,40 @@ typedef enum {
 	PHONGO_TYPEMAP_NONE,
 	PHONGO_TYPEMAP_NATIVE_ARRAY,
 	PHONGO_TYPEMAP_NATIVE_OBJECT,
-	PHONGO_TYPEMAP_CLASS
+	PHONGO_TYPEMAP_CLASS,
+	PHONGO_TYPEMAP_BSON,
+	PHONGO_TYPEMAP_RAW
 } php_phongo_bson_typemap_types;
 
-typedef struct {
-	php_phongo_field_path*        entry;
+/* fieldPaths type map entries are compiled into a trie keyed by path segment.
+ * The "$" wildcard segment is stored in a dedicated branch. Nodes that
+ * terminate a field path have a non-zero order, which records the position of
+ * the entry in the type map so that earlier entries take precedence. The paths
+ * of the include and exclude type map entries are compiled the same way. */
+typedef struct _php_phongo_field_path_node php_phongo_field_path_node;
+
+struct _php_phongo_field_path_node {
+	HashTable*                    children;
+	php_phongo_field_path_node*   wildcard;
 	php_phongo_bson_typemap_types node_type;
 	zend_class_entry*             node_ce;
-} php_phongo_field_path_map_element;
+	uint32_t                      order;
+};
+
+typedef struct {
+	php_phongo_field_path_node root;
+	uint32_t                   size;
+	uint32_t                   ref_count;
+} php_phongo_field_path_map;
+
+/* Flags for BSON value types that the "types" type map element converts to
+ * PHP scalars instead of objects. */
+typedef enum {
+	PHONGO_TYPEMAP_SCALAR_OBJECTID   = 1 << 0,
+	PHONGO_TYPEMAP_SCALAR_DATE       = 1 << 1,
+	PHONGO_TYPEMAP_SCALAR_DECIMAL128 = 1 << 2,
+	PHONGO_TYPEMAP_SCALAR_BINARY     = 1 << 3
+} php_phongo_bson_typemap_scalar_types;
 
 typedef struct {
 	php_phongo_bson_typemap_types document_type;
@@ -60,19 +86,22 @@ typedef struct {
 	zend_class_entry*             array;
 	php_phongo_bson_typemap_types root_type;
 	zend_class_entry*             root;
-	struct {
-		php_phongo_field_path_map_element** map;
-		size_t                              allocated_size;
-		size_t                              size;
-	} field_paths;
+	php_phongo_field_path_map*    field_paths;
+	php_phongo_field_path_map*    field_filter;
+	bool                          field_filter_exclude;
+	uint32_t                      scalar_types;
 } php_phongo_bson_typemap;
 
 typedef struct {
-	zval                    zchild;
-	php_phongo_bson_typemap map;
-	zend_class_entry*       odm;
-	bool                    is_visiting_array;
-	php_phongo_field_path*  field_path;
+	zval                        zchild;
+	php_phongo_bson_typemap     map;
+	zend_class_entry*           odm;
+	bool                        is_visiting_array;
+	bool                        is_visiting_object;
+	php_phongo_field_path*      field_path;
+	HashTable*                  key_cache;
+	php_phongo_field_path_node* filter_node;
+	zend_object*                hydrate;
 } php_phongo_bson_state;
 
 #define PHONGO_BSON_INIT_STATE(s)                       \
@@ -95,13 +124,21 @@ void                   php_phongo_field_path_write_type_at_current_level(php_pho
 bool                   php_phongo_field_path_push(php_phongo_field_path* field_path, const char* element, php_phongo_bson_field_path_item_types element_type);
 bool                   php_phongo_field_path_pop(php_phongo_field_path* field_path);
 
+bool php_phongo_bson_init_static_from_data(bson_t* bson, const unsigned char* data, size_t data_len);
+
 bool php_phongo_bson_to_zval(const unsigned char* data, int data_len, zval* out);
 bool php_phongo_bson_to_zval_ex(const unsigned char* data, int data_len, php_phongo_bson_state* state);
+bool php_phongo_bson_doc_to_zval_ex(const bson_t* b, php_phongo_bson_state* state);
 
 bool php_phongo_bson_value_to_zval(const bson_value_t* value, zval* zv);
+bool php_phongo_bson_iter_to_zval(const bson_iter_t* iter, zval* zv);
 
 bool php_phongo_bson_typemap_to_state(zval* typemap, php_phongo_bson_typemap* map);
 void php_phongo_bson_typemap_dtor(php_phongo_bson_typemap* map);
+void php_phongo_bson_typemap_cache_dtor(zval* zv);
+
+HashTable* php_phongo_bson_key_cache_new(void);
+void       php_phongo_bson_key_cache_free(HashTable* key_cache);
 
 void php_phongo_bson_new_timestamp_from_increment_and_timestamp(zval* object, uint32_t increment, uint32_t timestamp);
 void php_phongo_bson_new_int64(zval* object, int64_t integer);
@@ -24,6 +24,8 @@
 #include "phongo_bson_encode.h"
 #include "phongo_compat.h"
 #include "phongo_error.h"
+#include "phongo_probes.h"
+#include "phongo_util.h"
 
 #undef MONGOC_LOG_DOMAIN
 #define MONGOC_LOG_DOMAIN "PHONGO-BSON"
@@ -45,6 +47,20 @@
 /* Forwards declarations */
 static void php_phongo_zval_to_bson_internal(zval* data, php_phongo_field_path* field_path, php_phongo_bson_flags_t flags, bson_t* bson, bson_t** bson_out);
 
+/* Formats an integer key and returns its length. Keys in the range of uint32_t
+ * use bson_uint32_to_string(), which returns precomputed strings for small
+ * values (i.e. typical array indexes) and otherwise writes to the buffer. */
+static size_t php_phongo_bson_numeric_key(zend_long num_key, char* buf, size_t buf_len, const char** key) /* {{{ */
+{
+	if (num_key >= 0 && (zend_ulong) num_key <= UINT32_MAX) {
+		return bson_uint32_to_string((uint32_t) num_key, key, buf, buf_len);
+	}
+
+	*key = buf;
+
+	return (size_t) snprintf(buf, buf_len, ZEND_LONG_FMT, num_key);
+} /* }}} */
+
 /* Determines whether the argument should be serialized as a BSON array or
  * document. IS_ARRAY is returned if the argument's keys are a sequence of
  * integers starting at zero; otherwise, IS_OBJECT is returned. */
@@ -57,6 +73,12 @@ static int php_phongo_is_array_or_document(zval* val) /* {{{ */
 		return IS_OBJECT;
 	}
 
+	/* The keys of a packed array without holes are always the sequence of
+	 * integers starting at zero, so there is no need to walk them. */
+	if (ht_data && HT_IS_PACKED(ht_data) && HT_IS_WITHOUT_HOLES(ht_data)) {
+		return IS_ARRAY;
+	}
+
 	count = ht_data ? zend_hash_num_elements(ht_data) : 0;
 	if (count > 0) {
 		zend_string* key;
@@ -82,6 +104,172 @@ static int php_phongo_is_array_or_document(zval* val) /* {{{ */
 	return IS_ARRAY;
 } /* }}} */
 
+/* Identifies how an object is encoded. Objects that are not instances of a
+ * MongoDB\BSON\Type (or CursorId) are encoded as embedded documents, either
+ * from their property table or, for MongoDB\BSON\PropertyCodec instances,
+ * directly from their declared property slots. */
+typedef enum {
+	PHONGO_BSON_ENCODE_DOCUMENT,
+	PHONGO_BSON_ENCODE_PROPERTIES,
+	PHONGO_BSON_ENCODE_CURSORID,
+	PHONGO_BSON_ENCODE_PERSISTABLE,
+	PHONGO_BSON_ENCODE_SERIALIZABLE,
+	PHONGO_BSON_ENCODE_OBJECTID,
+	PHONGO_BSON_ENCODE_UTCDATETIME,
+	PHONGO_BSON_ENCODE_BINARY,
+	PHONGO_BSON_ENCODE_DECIMAL128,
+	PHONGO_BSON_ENCODE_INT64,
+	PHONGO_BSON_ENCODE_REGEX,
+	PHONGO_BSON_ENCODE_JAVASCRIPT,
+	PHONGO_BSON_ENCODE_TIMESTAMP,
+	PHONGO_BSON_ENCODE_MAXKEY,
+	PHONGO_BSON_ENCODE_MINKEY,
+	PHONGO_BSON_ENCODE_DBPOINTER,
+	PHONGO_BSON_ENCODE_SYMBOL,
+	PHONGO_BSON_ENCODE_UNDEFINED,
+	PHONGO_BSON_ENCODE_BSON_DOCUMENT,
+	PHONGO_BSON_ENCODE_BSON_PACKEDARRAY,
+	PHONGO_BSON_ENCODE_UNKNOWN_TYPE
+} php_phongo_bson_encode_type;
+
+/* Encoding types of the driver's classes, keyed by class entry. This is filled
+ * in MINIT and is read-only afterwards. Encoding types of other classes are
+ * resolved on first use and cached for the duration of the request. */
+static HashTable php_phongo_bson_encode_types;
+
+/* Resolves the encoding type of a class by checking the classes and interfaces
+ * it may extend or implement. */
+static php_phongo_bson_encode_type php_phongo_bson_resolve_encode_type(zend_class_entry* ce) /* {{{ */
+{
+	if (instanceof_function(ce, php_phongo_cursorid_ce)) {
+		return PHONGO_BSON_ENCODE_CURSORID;
+	}
+
+	if (!instanceof_function(ce, php_phongo_type_ce)) {
+		if (instanceof_function(ce, php_phongo_propertycodec_ce)) {
+			return PHONGO_BSON_ENCODE_PROPERTIES;
+		}
+
+		return PHONGO_BSON_ENCODE_DOCUMENT;
+	}
+
+	if (instanceof_function(ce, php_phongo_persistable_ce)) {
+		return PHONGO_BSON_ENCODE_PERSISTABLE;
+	}
+	if (instanceof_function(ce, php_phongo_serializable_ce)) {
+		return PHONGO_BSON_ENCODE_SERIALIZABLE;
+	}
+	if (instanceof_function(ce, php_phongo_objectid_ce)) {
+		return PHONGO_BSON_ENCODE_OBJECTID;
+	}
+	if (instanceof_function(ce, php_phongo_utcdatetime_ce)) {
+		return PHONGO_BSON_ENCODE_UTCDATETIME;
+	}
+	if (instanceof_function(ce, php_phongo_binary_ce)) {
+		return PHONGO_BSON_ENCODE_BINARY;
+	}
+	if (instanceof_function(ce, php_phongo_decimal128_ce)) {
+		return PHONGO_BSON_ENCODE_DECIMAL128;
+	}
+	if (instanceof_function(ce, php_phongo_int64_ce)) {
+		return PHONGO_BSON_ENCODE_INT64;
+	}
+	if (instanceof_function(ce, php_phongo_regex_ce)) {
+		return PHONGO_BSON_ENCODE_REGEX;
+	}
+	if (instanceof_function(ce, php_phongo_javascript_ce)) {
+		return PHONGO_BSON_ENCODE_JAVASCRIPT;
+	}
+	if (instanceof_function(ce, php_phongo_timestamp_ce)) {
+		return PHONGO_BSON_ENCODE_TIMESTAMP;
+	}
+	if (instanceof_function(ce, php_phongo_maxkey_ce)) {
+		return PHONGO_BSON_ENCODE_MAXKEY;
+	}
+	if (instanceof_function(ce, php_phongo_minkey_ce)) {
+		return PHONGO_BSON_ENCODE_MINKEY;
+	}
+
+	/* Deprecated types */
+	if (instanceof_function(ce, php_phongo_dbpointer_ce)) {
+		return PHONGO_BSON_ENCODE_DBPOINTER;
+	}
+	if (instanceof_function(ce, php_phongo_symbol_ce)) {
+		return PHONGO_BSON_ENCODE_SYMBOL;
+	}
+	if (instanceof_function(ce, php_phongo_undefined_ce)) {
+		return PHONGO_BSON_ENCODE_UNDEFINED;
+	}
+
+	if (instanceof_function(ce, php_phongo_document_ce)) {
+		return PHONGO_BSON_ENCODE_BSON_DOCUMENT;
+	}
+	if (instanceof_function(ce, php_phongo_packedarray_ce)) {
+		return PHONGO_BSON_ENCODE_BSON_PACKEDARRAY;
+	}
+
+	return PHONGO_BSON_ENCODE_UNKNOWN_TYPE;
+} /* }}} */
+
+static void php_phongo_bson_add_encode_type(HashTable* ht, zend_class_entry* ce) /* {{{ */
+{
+	zval type;
+
+	ZVAL_LONG(&type, php_phongo_bson_resolve_encode_type(ce));
+	zend_hash_index_add_new(ht, (zend_ulong) (uintptr_t) ce, &type);
+} /* }}} */
+
+static php_phongo_bson_encode_type php_phongo_bson_get_encode_type(zend_class_entry* ce) /* {{{ */
+{
+	HashTable* cache = MONGODB_G(encode_type_cache);
+	zval*      type;
+
+	if ((type = zend_hash_index_find(&php_phongo_bson_encode_types, (zend_ulong) (uintptr_t) ce))) {
+		return (php_phongo_bson_encode_type) Z_LVAL_P(type);
+	}
+
+	if (!cache) {
+		return php_phongo_bson_resolve_encode_type(ce);
+	}
+
+	if (!(type = zend_hash_index_find(cache, (zend_ulong) (uintptr_t) ce))) {
+		php_phongo_bson_add_encode_type(cache, ce);
+		type = zend_hash_index_find(cache, (zend_ulong) (uintptr_t) ce);
+	}
+
+	return (php_phongo_bson_encode_type) Z_LVAL_P(type);
+} /* }}} */
+
+/* Registers the encoding types of the driver's classes. This must be called
+ * in MINIT after all classes have been registered. */
+void php_phongo_bson_encode_types_init(void) /* {{{ */
+{
+	zend_hash_init(&php_phongo_bson_encode_types, 32, NULL, NULL, 1);
+
+	php_phongo_bson_add_encode_type(&php_phongo_bson_encode_types, php_phongo_cursorid_ce);
+	php_phongo_bson_add_encode_type(&php_phongo_bson_encode_types, php_phongo_objectid_ce);
+	php_phongo_bson_add_encode_type(&php_phongo_bson_encode_types, php_phongo_utcdatetime_ce);
+	php_phongo_bson_add_encode_type(&php_phongo_bson_encode_types, php_phongo_binary_ce);
+	php_phongo_bson_add_encode_type(&php_phongo_bson_encode_types, php_phongo_decimal128_ce);
+	php_phongo_bson_add_encode_type(&php_phongo_bson_encode_types, php_phongo_int64_ce);
+	php_phongo_bson_add_encode_type(&php_phongo_bson_encode_types, php_phongo_regex_ce);
+	php_phongo_bson_add_encode_type(&php_phongo_bson_encode_types, php_phongo_javascript_ce);
+	php_phongo_bson_add_encode_type(&php_phongo_bson_encode_types, php_phongo_timestamp_ce);
+	php_phongo_bson_add_encode_type(&php_phongo_bson_encode_types, php_phongo_maxkey_ce);
+	php_phongo_bson_add_encode_type(&php_phongo_bson_encode_types, php_phongo_minkey_ce);
+	php_phongo_bson_add_encode_type(&php_phongo_bson_encode_types, php_phongo_dbpointer_ce);
+	php_phongo_bson_add_encode_type(&php_phongo_bson_encode_types, php_phongo_symbol_ce);
+	php_phongo_bson_add_encode_type(&php_phongo_bson_encode_types, php_phongo_undefined_ce);
+	php_phongo_bson_add_encode_type(&php_phongo_bson_encode_types, php_phongo_document_ce);
+	php_phongo_bson_add_encode_type(&php_phongo_bson_encode_types, php_phongo_packedarray_ce);
+	php_phongo_bson_add_encode_type(&php_phongo_bson_encode_types, zend_standard_class_def);
+} /* }}} */
+
+void php_phongo_bson_encode_types_dtor(void) /* {{{ */
+{
+	zend_hash_destroy(&php_phongo_bson_encode_types);
+} /* }}} */
+
 /* Appends the array or object argument to the BSON document. If the object is
  * an instance of MongoDB\BSON\Serializable, the return value of bsonSerialize()
  * will be appended as an embedded document. Other MongoDB\BSON\Type instances
@@ -89,13 +277,19 @@ static int php_phongo_is_array_or_document(zval* val) /* {{{ */
  * will be appended as an embedded document. */
 static void php_phongo_bson_append_object(bson_t* bson, php_phongo_field_path* field_path, php_phongo_bson_flags_t flags, const char* key, long key_len, zval* object) /* {{{ */
 {
-	if (Z_TYPE_P(object) == IS_OBJECT && instanceof_function(Z_OBJCE_P(object), php_phongo_cursorid_ce)) {
-		bson_append_int64(bson, key, key_len, Z_CURSORID_OBJ_P(object)->id);
-		return;
+	php_phongo_bson_encode_type type = PHONGO_BSON_ENCODE_DOCUMENT;
+
+	if (Z_TYPE_P(object) == IS_OBJECT) {
+		type = php_phongo_bson_get_encode_type(Z_OBJCE_P(object));
 	}
 
-	if (Z_TYPE_P(object) == IS_OBJECT && instanceof_function(Z_OBJCE_P(object), php_phongo_type_ce)) {
-		if (instanceof_function(Z_OBJCE_P(object), php_phongo_serializable_ce)) {
+	switch (type) {
+		case PHONGO_BSON_ENCODE_CURSORID:
+			bson_append_int64(bson, key, key_len, Z_CURSORID_OBJ_P(object)->id);
+			return;
+
+		case PHONGO_BSON_ENCODE_PERSISTABLE:
+		case PHONGO_BSON_ENCODE_SERIALIZABLE: {
 			zval   obj_data;
 			bson_t child;
 
@@ -120,9 +314,9 @@ static void php_phongo_bson_append_object(bson_t* bson, php_phongo_field_path* f
 
 			/* Persistable objects must always be serialized as BSON documents;
 			 * otherwise, infer based on bsonSerialize()'s return value. */
-			if (instanceof_function(Z_OBJCE_P(object), php_phongo_persistable_ce) || php_phongo_is_array_or_document(&obj_data) == IS_OBJECT) {
+			if (type == PHONGO_BSON_ENCODE_PERSISTABLE || php_phongo_is_array_or_document(&obj_data) == IS_OBJECT) {
 				bson_append_document_begin(bson, key, key_len, &child);
-				if (instanceof_function(Z_OBJCE_P(object), php_phongo_persistable_ce)) {
+				if (type == PHONGO_BSON_ENCODE_PERSISTABLE) {
 					bson_append_binary(&child, PHONGO_ODM_FIELD_NAME, -1, 0x80, (const uint8_t*) Z_OBJCE_P(object)->name->val, Z_OBJCE_P(object)->name->len);
 				}
 				php_phongo_zval_to_bson_internal(&obj_data, field_path, flags, &child, NULL);
@@ -137,112 +331,116 @@ static void php_phongo_bson_append_object(bson_t* bson, php_phongo_field_path* f
 			return;
 		}
 
-		if (instanceof_function(Z_OBJCE_P(object), php_phongo_objectid_ce)) {
-			bson_oid_t             oid;
+		case PHONGO_BSON_ENCODE_OBJECTID: {
 			php_phongo_objectid_t* intern = Z_OBJECTID_OBJ_P(object);
 
-			mongoc_log(MONGOC_LOG_LEVEL_TRACE, MONGOC_LOG_DOMAIN, "encoding ObjectId");
-			bson_oid_init_from_string(&oid, intern->oid);
-			bson_append_oid(bson, key, key_len, &oid);
+			bson_append_oid(bson, key, key_len, &intern->oid);
 			return;
 		}
-		if (instanceof_function(Z_OBJCE_P(object), php_phongo_utcdatetime_ce)) {
+
+		case PHONGO_BSON_ENCODE_UTCDATETIME: {
 			php_phongo_utcdatetime_t* intern = Z_UTCDATETIME_OBJ_P(object);
 
-			mongoc_log(MONGOC_LOG_LEVEL_TRACE, MONGOC_LOG_DOMAIN, "encoding UTCDateTime");
 			bson_append_date_time(bson, key, key_len, intern->milliseconds);
 			return;
 		}
-		if (instanceof_function(Z_OBJCE_P(object), php_phongo_binary_ce)) {
+
+		case PHONGO_BSON_ENCODE_BINARY: {
 			php_phongo_binary_t* intern = Z_BINARY_OBJ_P(object);
 
-			mongoc_log(MONGOC_LOG_LEVEL_TRACE, MONGOC_LOG_DOMAIN, "encoding Binary");
-			bson_append_binary(bson, key, key_len, intern->type, (const uint8_t*) intern->data, (uint32_t) intern->data_len);
+			bson_append_binary(bson, key, key_len, intern->type, (const uint8_t*) ZSTR_VAL(intern->data), (uint32_t) ZSTR_LEN(intern->data));
 			return;
 		}
-		if (instanceof_function(Z_OBJCE_P(object), php_phongo_decimal128_ce)) {
+
+		case PHONGO_BSON_ENCODE_DECIMAL128: {
 			php_phongo_decimal128_t* intern = Z_DECIMAL128_OBJ_P(object);
 
-			mongoc_log(MONGOC_LOG_LEVEL_TRACE, MONGOC_LOG_DOMAIN, "encoding Decimal128");
 			bson_append_decimal128(bson, key, key_len, &intern->decimal);
 			return;
 		}
-		if (instanceof_function(Z_OBJCE_P(object), php_phongo_int64_ce)) {
+
+		case PHONGO_BSON_ENCODE_INT64: {
 			php_phongo_int64_t* intern = Z_INT64_OBJ_P(object);
 
-			mongoc_log(MONGOC_LOG_LEVEL_TRACE, MONGOC_LOG_DOMAIN, "encoding Int64");
 			bson_append_int64(bson, key, key_len, intern->integer);
 			return;
 		}
-		if (instanceof_function(Z_OBJCE_P(object), php_phongo_regex_ce)) {
+
+		case PHONGO_BSON_ENCODE_REGEX: {
 			php_phongo_regex_t* intern = Z_REGEX_OBJ_P(object);
 
-			mongoc_log(MONGOC_LOG_LEVEL_TRACE, MONGOC_LOG_DOMAIN, "encoding Regex");
 			bson_append_regex(bson, key, key_len, intern->pattern, intern->flags);
 			return;
 		}
-		if (instanceof_function(Z_OBJCE_P(object), php_phongo_javascript_ce)) {
+
+		case PHONGO_BSON_ENCODE_JAVASCRIPT: {
 			php_phongo_javascript_t* intern = Z_JAVASCRIPT_OBJ_P(object);
 
 			if (intern->scope) {
-				mongoc_log(MONGOC_LOG_LEVEL_TRACE, MONGOC_LOG_DOMAIN, "encoding Javascript with scope");
 				bson_append_code_with_scope(bson, key, key_len, intern->code, intern->scope);
 			} else {
-				mongoc_log(MONGOC_LOG_LEVEL_TRACE, MONGOC_LOG_DOMAIN, "encoding Javascript without scope");
 				bson_append_code(bson, key, key_len, intern->code);
 			}
 			return;
 		}
-		if (instanceof_function(Z_OBJCE_P(object), php_phongo_timestamp_ce)) {
+
+		case PHONGO_BSON_ENCODE_TIMESTAMP: {
 			php_phongo_timestamp_t* intern = Z_TIMESTAMP_OBJ_P(object);
 
-			mongoc_log(MONGOC_LOG_LEVEL_TRACE, MONGOC_LOG_DOMAIN, "encoding Timestamp");
 			bson_append_timestamp(bson, key, key_len, intern->timestamp, intern->increment);
 			return;
 		}
-		if (instanceof_function(Z_OBJCE_P(object), php_phongo_maxkey_ce)) {
-			mongoc_log(MONGOC_LOG_LEVEL_TRACE, MONGOC_LOG_DOMAIN, "encoding MaxKey");
+
+		case PHONGO_BSON_ENCODE_MAXKEY:
 			bson_append_maxkey(bson, key, key_len);
 			return;
-		}
-		if (instanceof_function(Z_OBJCE_P(object), php_phongo_minkey_ce)) {
-			mongoc_log(MONGOC_LOG_LEVEL_TRACE, MONGOC_LOG_DOMAIN, "encoding MinKey");
+
+		case PHONGO_BSON_ENCODE_MINKEY:
 			bson_append_minkey(bson, key, key_len);
 			return;
-		}
 
 		/* Deprecated types */
-		if (instanceof_function(Z_OBJCE_P(object), php_phongo_dbpointer_ce)) {
+		case PHONGO_BSON_ENCODE_DBPOINTER: {
 			bson_oid_t              oid;
 			php_phongo_dbpointer_t* intern = Z_DBPOINTER_OBJ_P(object);
 
-			mongoc_log(MONGOC_LOG_LEVEL_TRACE, MONGOC_LOG_DOMAIN, "encoding DBPointer");
 			bson_oid_init_from_string(&oid, intern->id);
 			bson_append_dbpointer(bson, key, key_len, intern->ref, &oid);
 			return;
 		}
-		if (instanceof_function(Z_OBJCE_P(object), php_phongo_symbol_ce)) {
+
+		case PHONGO_BSON_ENCODE_SYMBOL: {
 			php_phongo_symbol_t* intern = Z_SYMBOL_OBJ_P(object);
 
-			mongoc_log(MONGOC_LOG_LEVEL_TRACE, MONGOC_LOG_DOMAIN, "encoding Symbol");
 			bson_append_symbol(bson, key, key_len, intern->symbol, intern->symbol_len);
 			return;
 		}
-		if (instanceof_function(Z_OBJCE_P(object), php_phongo_undefined_ce)) {
-			mongoc_log(MONGOC_LOG_LEVEL_TRACE, MONGOC_LOG_DOMAIN, "encoding Undefined");
+
+		case PHONGO_BSON_ENCODE_UNDEFINED:
 			bson_append_undefined(bson, key, key_len);
 			return;
-		}
 
-		phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE, "Unexpected %s instance: %s", ZSTR_VAL(php_phongo_type_ce->name), ZSTR_VAL(Z_OBJCE_P(object)->name));
-		return;
-	} else {
-		bson_t child;
+		case PHONGO_BSON_ENCODE_BSON_DOCUMENT:
+			bson_append_document(bson, key, key_len, Z_DOCUMENT_OBJ_P(object)->bson);
+			return;
+
+		case PHONGO_BSON_ENCODE_BSON_PACKEDARRAY:
+			bson_append_array(bson, key, key_len, Z_PACKEDARRAY_OBJ_P(object)->bson);
+			return;
+
+		case PHONGO_BSON_ENCODE_UNKNOWN_TYPE:
+			phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE, "Unexpected %s instance: %s", ZSTR_VAL(php_phongo_type_ce->name), ZSTR_VAL(Z_OBJCE_P(object)->name));
+			return;
 
-		mongoc_log(MONGOC_LOG_LEVEL_TRACE, MONGOC_LOG_DOMAIN, "encoding document");
-		bson_append_document_begin(bson, key, key_len, &child);
-		php_phongo_zval_to_bson_internal(object, field_path, flags, &child, NULL);
-		bson_append_document_end(bson, &child);
+		case PHONGO_BSON_ENCODE_DOCUMENT:
+		case PHONGO_BSON_ENCODE_PROPERTIES:
+		default: {
+			bson_t child;
+
+			bson_append_document_begin(bson, key, key_len, &child);
+			php_phongo_zval_to_bson_internal(object, field_path, flags, &child, NULL);
+			bson_append_document_end(bson, &child);
+		}
 	}
 } /* }}} */
 
@@ -251,8 +449,9 @@ static void php_phongo_bson_append_object(bson_t* bson, php_phongo_field_path* f
  * will defer to php_phongo_bson_append_object(). */
 static void php_phongo_bson_append(bson_t* bson, php_phongo_field_path* field_path, php_phongo_bson_flags_t flags, const char* key, long key_len, zval* entry) /* {{{ */
 {
-	php_phongo_field_path_write_item_at_current_level(field_path, key);
-
+	/* The field path only records the keys of the documents and arrays being
+	 * appended. The current key is written when an error is reported or before
+	 * descending into an embedded document or array. */
 try_again:
 	switch (Z_TYPE_P(entry)) {
 		case IS_NULL:
@@ -275,10 +474,14 @@ try_again:
 			break;
 
 		case IS_STRING:
-			if (bson_utf8_validate(Z_STRVAL_P(entry), Z_STRLEN_P(entry), true)) {
+			if (php_phongo_utf8_validate(Z_STRVAL_P(entry), Z_STRLEN_P(entry), true)) {
 				bson_append_utf8(bson, key, key_len, Z_STRVAL_P(entry), Z_STRLEN_P(entry));
 			} else {
-				char* path_string = php_phongo_field_path_as_string(field_path);
+				char* path_string;
+
+				php_phongo_field_path_write_item_at_current_level(field_path, key);
+				path_string = php_phongo_field_path_as_string(field_path);
+
 				phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE, "Detected invalid UTF-8 for field path \"%s\": %s", path_string, Z_STRVAL_P(entry));
 				efree(path_string);
 			}
@@ -290,17 +493,20 @@ try_again:
 				HashTable* tmp_ht = HASH_OF(entry);
 
 				if (!php_phongo_zend_hash_apply_protection_begin(tmp_ht)) {
-					char* path_string = php_phongo_field_path_as_string(field_path);
+					char* path_string;
+
+					php_phongo_field_path_write_item_at_current_level(field_path, key);
+					path_string = php_phongo_field_path_as_string(field_path);
+
 					phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE, "Detected recursion for field path \"%s\"", path_string);
 					efree(path_string);
 					break;
 				}
 
 				bson_append_array_begin(bson, key, key_len, &child);
-				php_phongo_field_path_write_type_at_current_level(field_path, PHONGO_FIELD_PATH_ITEM_ARRAY);
-				field_path->size++;
+				php_phongo_field_path_push(field_path, key, PHONGO_FIELD_PATH_ITEM_ARRAY);
 				php_phongo_zval_to_bson_internal(entry, field_path, flags, &child, NULL);
-				field_path->size--;
+				php_phongo_field_path_pop(field_path);
 				bson_append_array_end(bson, &child);
 
 				php_phongo_zend_hash_apply_protection_end(tmp_ht);
@@ -309,21 +515,41 @@ try_again:
 			PHONGO_BREAK_INTENTIONALLY_MISSING
 
 		case IS_OBJECT: {
-			HashTable* tmp_ht = HASH_OF(entry);
+			HashTable* tmp_ht = NULL;
+			bool       from_slots;
+			bool       is_protected;
+
+			/* Objects encoded from their property slots are protected without
+			 * building their property table */
+			from_slots = Z_TYPE_P(entry) == IS_OBJECT && php_phongo_bson_get_encode_type(Z_OBJCE_P(entry)) == PHONGO_BSON_ENCODE_PROPERTIES && !PHONGO_OBJ_IS_LAZY(Z_OBJ_P(entry));
+
+			if (from_slots) {
+				is_protected = php_phongo_zend_object_apply_protection_begin(entry);
+			} else {
+				tmp_ht       = HASH_OF(entry);
+				is_protected = php_phongo_zend_hash_apply_protection_begin(tmp_ht);
+			}
+
+			if (!is_protected) {
+				char* path_string;
+
+				php_phongo_field_path_write_item_at_current_level(field_path, key);
+				path_string = php_phongo_field_path_as_string(field_path);
 
-			if (!php_phongo_zend_hash_apply_protection_begin(tmp_ht)) {
-				char* path_string = php_phongo_field_path_as_string(field_path);
 				phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE, "Detected recursion for field path \"%s\"", path_string);
 				efree(path_string);
 				break;
 			}
 
-			php_phongo_field_path_write_type_at_current_level(field_path, PHONGO_FIELD_PATH_ITEM_DOCUMENT);
-			field_path->size++;
+			php_phongo_field_path_push(field_path, key, PHONGO_FIELD_PATH_ITEM_DOCUMENT);
 			php_phongo_bson_append_object(bson, field_path, flags, key, key_len, entry);
-			field_path->size--;
+			php_phongo_field_path_pop(field_path);
 
-			php_phongo_zend_hash_apply_protection_end(tmp_ht);
+			if (from_slots) {
+				php_phongo_zend_object_apply_protection_end(entry);
+			} else {
+				php_phongo_zend_hash_apply_protection_end(tmp_ht);
+			}
 			break;
 		}
 
@@ -332,13 +558,158 @@ try_again:
 			goto try_again;
 
 		default: {
-			char* path_string = php_phongo_field_path_as_string(field_path);
+			char* path_string;
+
+			php_phongo_field_path_write_item_at_current_level(field_path, key);
+			path_string = php_phongo_field_path_as_string(field_path);
+
 			phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE, "Detected unsupported PHP type for field path \"%s\": %d (%s)", path_string, Z_TYPE_P(entry), zend_get_type_by_const(Z_TYPE_P(entry)));
 			efree(path_string);
 		}
 	}
 } /* }}} */
 
+/* Declared properties of a class implementing MongoDB\BSON\PropertyCodec. This
+ * is compiled on first use and cached for the duration of the request. Names
+ * are borrowed from the class' property table. Properties with hooks (PHP 8.4+)
+ * record the declaring class, so that they are read through their get hook
+ * instead of from their backing slot. */
+typedef struct {
+	zend_string*      name;
+	uint32_t          offset;
+	zend_class_entry* hook_scope;
+} php_phongo_bson_property_slot;
+
+typedef struct {
+	uint32_t                      num_slots;
+	php_phongo_bson_property_slot slots[1];
+} php_phongo_bson_property_map;
+
+/* qsort() compare callback for ordering property slots by offset, which is the
+ * order in which properties appear in the object's property table */
+static int php_phongo_bson_property_slot_compare(const void* a, const void* b) /* {{{ */
+{
+	uint32_t offset_a = ((const php_phongo_bson_property_slot*) a)->offset;
+	uint32_t offset_b = ((const php_phongo_bson_property_slot*) b)->offset;
+
+	return (offset_a > offset_b) - (offset_a < offset_b);
+} /* }}} */
+
+static php_phongo_bson_property_map* php_phongo_bson_property_map_compile(zend_class_entry* ce) /* {{{ */
+{
+	php_phongo_bson_property_map* map;
+	zend_string*                  name;
+	zend_property_info*           prop_info;
+	uint32_t                      num_slots = 0;
+
+	map = emalloc(sizeof(php_phongo_bson_property_map) + sizeof(php_phongo_bson_property_slot) * zend_hash_num_elements(&ce->properties_info));
+
+	ZEND_HASH_FOREACH_STR_KEY_PTR(&ce->properties_info, name, prop_info)
+	{
+		if (prop_info->flags & ZEND_ACC_STATIC) {
+			continue;
+		}
+
+#ifdef ZEND_ACC_SHADOW
+		/* Private properties of a parent class are only included for the
+		 * class declaring them before PHP 7.4 */
+		if (prop_info->flags & ZEND_ACC_SHADOW) {
+			continue;
+		}
+#endif
+
+#ifdef ZEND_ACC_VIRTUAL
+		/* Virtual properties only consist of hooks and have no slot */
+		if (prop_info->flags & ZEND_ACC_VIRTUAL) {
+			continue;
+		}
+#endif
+
+		map->slots[num_slots].name       = name;
+		map->slots[num_slots].offset     = prop_info->offset;
+		map->slots[num_slots].hook_scope = NULL;
+
+#if PHP_VERSION_ID >= 80400
+		if (prop_info->hooks) {
+			map->slots[num_slots].hook_scope = prop_info->ce;
+		}
+#endif
+
+		num_slots++;
+	}
+	ZEND_HASH_FOREACH_END();
+
+	map->num_slots = num_slots;
+
+	qsort((void*) map->slots, num_slots, sizeof(php_phongo_bson_property_slot), php_phongo_bson_property_slot_compare);
+
+	return map;
+} /* }}} */
+
+void php_phongo_bson_property_map_dtor(zval* zv) /* {{{ */
+{
+	efree(Z_PTR_P(zv));
+} /* }}} */
+
+/* Appends the initialized declared properties of a MongoDB\BSON\PropertyCodec
+ * instance, reading them from their slots instead of the property table. */
+static void php_phongo_bson_append_properties(bson_t* bson, php_phongo_field_path* field_path, php_phongo_bson_flags_t* flags, zval* object) /* {{{ */
+{
+	HashTable*                    cache = MONGODB_G(property_map_cache);
+	zend_object*                  obj   = Z_OBJ_P(object);
+	php_phongo_bson_property_map* map   = NULL;
+	uint32_t                      i;
+
+	if (cache) {
+		map = zend_hash_index_find_ptr(cache, (zend_ulong) (uintptr_t) obj->ce);
+	}
+
+	if (!map) {
+		map = php_phongo_bson_property_map_compile(obj->ce);
+
+		if (cache) {
+			zend_hash_index_add_new_ptr(cache, (zend_ulong) (uintptr_t) obj->ce, map);
+		}
+	}
+
+	for (i = 0; i < map->num_slots; i++) {
+		zend_string* name  = map->slots[i].name;
+		zval*        value = OBJ_PROP(obj, map->slots[i].offset);
+		zval         rv;
+
+		if (Z_TYPE_P(value) == IS_UNDEF) {
+			continue;
+		}
+
+		ZVAL_UNDEF(&rv);
+
+		if (map->slots[i].hook_scope) {
+			value = zend_read_property_ex(map->slots[i].hook_scope, obj, name, 1, &rv);
+
+			if (EG(exception)) {
+				zval_ptr_dtor(&rv);
+				break;
+			}
+		}
+
+		if ((*flags & PHONGO_BSON_ADD_ID) && zend_string_equals_literal(name, "_id")) {
+			*flags &= ~PHONGO_BSON_ADD_ID;
+		}
+
+		php_phongo_bson_append(bson, field_path, *flags & ~PHONGO_BSON_ADD_ID, ZSTR_VAL(name), ZSTR_LEN(name), value);
+
+		zval_ptr_dtor(&rv);
+
+		if (EG(exception)) {
+			break;
+		}
+	}
+
+	if (!cache) {
+		efree(map);
+	}
+} /* }}} */
+
 static void php_phongo_zval_to_bson_internal(zval* data, php_phongo_field_path* field_path, php_phongo_bson_flags_t flags, bson_t* bson, bson_t** bson_out) /* {{{ */
 {
 	HashTable* ht_data = NULL;
@@ -389,11 +760,31 @@ static void php_phongo_zval_to_bson_internal(zval* data, php_phongo_field_path*
 				break;
 			}
 
+			/* A Document is already encoded, so its fields are copied as-is
+			 * without being decoded. */
+			if (instanceof_function(Z_OBJCE_P(data), php_phongo_document_ce)) {
+				const bson_t* document = Z_DOCUMENT_OBJ_P(data)->bson;
+
+				bson_concat(bson, document);
+
+				if ((flags & PHONGO_BSON_ADD_ID) && bson_has_field(document, "_id")) {
+					flags &= ~PHONGO_BSON_ADD_ID;
+				}
+
+				break;
+			}
+
 			if (instanceof_function(Z_OBJCE_P(data), php_phongo_type_ce)) {
 				phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE, "%s instance %s cannot be serialized as a root element", ZSTR_VAL(php_phongo_type_ce->name), ZSTR_VAL(Z_OBJCE_P(data)->name));
 				return;
 			}
 
+			/* Lazy objects are initialized through their property table */
+			if (php_phongo_bson_get_encode_type(Z_OBJCE_P(data)) == PHONGO_BSON_ENCODE_PROPERTIES && !PHONGO_OBJ_IS_LAZY(Z_OBJ_P(data))) {
+				php_phongo_bson_append_properties(bson, field_path, &flags, data);
+				break;
+			}
+
 			ht_data                 = Z_OBJ_HT_P(data)->get_properties(PHONGO_COMPAT_OBJ_P(data));
 			ht_data_from_properties = true;
 			break;
@@ -406,10 +797,13 @@ static void php_phongo_zval_to_bson_internal(zval* data, php_phongo_field_path*
 			return;
 	}
 
-	{
+	if (ht_data) {
 		zend_string* string_key = NULL;
 		zend_ulong   num_key    = 0;
 		zval*        value;
+		char         num_key_buf[MAX_LENGTH_OF_LONG + 1];
+		const char*  key;
+		size_t       key_len;
 
 		ZEND_HASH_FOREACH_KEY_VAL_IND(ht_data, num_key, string_key, value)
 		{
@@ -438,16 +832,17 @@ static void php_phongo_zval_to_bson_internal(zval* data, php_phongo_field_path*
 				}
 			}
 
-			/* Ensure we're working with a string key */
-			if (!string_key) {
-				string_key = zend_long_to_str(num_key);
+			/* Numeric keys are formatted without allocating. The key remains
+			 * valid until php_phongo_bson_append() returns, which is as long
+			 * as the field path may refer to it. */
+			if (string_key) {
+				key     = ZSTR_VAL(string_key);
+				key_len = ZSTR_LEN(string_key);
 			} else {
-				zend_string_addref(string_key);
+				key_len = php_phongo_bson_numeric_key((zend_long) num_key, num_key_buf, sizeof(num_key_buf), &key);
 			}
 
-			php_phongo_bson_append(bson, field_path, flags & ~PHONGO_BSON_ADD_ID, ZSTR_VAL(string_key), strlen(ZSTR_VAL(string_key)), value);
-
-			zend_string_release(string_key);
+			php_phongo_bson_append(bson, field_path, flags & ~PHONGO_BSON_ADD_ID, key, key_len, value);
 		}
 		ZEND_HASH_FOREACH_END();
 	}
@@ -457,7 +852,6 @@ static void php_phongo_zval_to_bson_internal(zval* data, php_phongo_field_path*
 
 		bson_oid_init(&oid, NULL);
 		bson_append_oid(bson, "_id", strlen("_id"), &oid);
-		mongoc_log(MONGOC_LOG_LEVEL_TRACE, MONGOC_LOG_DOMAIN, "Added new _id");
 	}
 
 	if (flags & PHONGO_BSON_RETURN_ID && bson_out) {
@@ -480,6 +874,101 @@ cleanup:
 	}
 } /* }}} */
 
+/* Short-lived BSON documents (e.g. documents that are encoded only to be copied
+ * elsewhere) may be built in a request-scoped scratch buffer instead of being
+ * allocated through libbson's vtable, which uses persistent (i.e. system)
+ * memory. The buffer is allocated with ZendMM, keeps its size between uses, and
+ * is freed in RSHUTDOWN. A buffer that grew past
+ * PHONGO_BSON_SCRATCH_MAX_RETAINED_SIZE for a large document is freed as soon as
+ * that document is released, so that it does not hold on to memory counted
+ * against memory_limit for the rest of the request.
+ *
+ * php_phongo_bson_erealloc() may be passed to bson_writer_new() for any buffer
+ * that is owned by the request and released with efree(). */
+void* php_phongo_bson_erealloc(void* mem, size_t num_bytes, void* ctx ARG_UNUSED) /* {{{ */
+{
+	return erealloc(mem, num_bytes);
+} /* }}} */
+
+/* Returns an empty document to be released with php_phongo_bson_scratch_end()
+ * before the request ends. The document is built in the scratch buffer unless
+ * that is already in use (e.g. by a bsonSerialize() method encoding another
+ * document), in which case a heap-allocated document is returned. Either way,
+ * at least size_hint bytes are reserved up front so that encoding a document
+ * of the expected size does not need to grow the buffer. A hint larger than
+ * the scratch buffer may retain also gets a heap-allocated document, since the
+ * buffer would otherwise be grown only to be freed again. */
+bson_t* php_phongo_bson_scratch_begin(size_t size_hint) /* {{{ */
+{
+	bson_t* bson;
+
+	if (size_hint > BSON_MAX_SIZE) {
+		size_hint = BSON_MAX_SIZE;
+	}
+
+	if (MONGODB_G(bson_scratch_in_use) || size_hint > PHONGO_BSON_SCRATCH_MAX_RETAINED_SIZE) {
+		return bson_sized_new(size_hint);
+	}
+
+	if (!MONGODB_G(bson_scratch)) {
+		MONGODB_G(bson_scratch) = bson_writer_new(&MONGODB_G(bson_scratch_buf), &MONGODB_G(bson_scratch_buf_len), 0, php_phongo_bson_erealloc, NULL);
+	}
+
+	/* The writer only refers to the buffer through the module globals, so it
+	 * may be grown here while no document is being written. */
+	if (MONGODB_G(bson_scratch_buf_len) < size_hint) {
+		MONGODB_G(bson_scratch_buf)     = erealloc(MONGODB_G(bson_scratch_buf), size_hint);
+		MONGODB_G(bson_scratch_buf_len) = size_hint;
+	}
+
+	if (!bson_writer_begin(MONGODB_G(bson_scratch), &bson)) {
+		return bson_sized_new(size_hint);
+	}
+
+	MONGODB_G(bson_scratch_in_use) = true;
+
+	return bson;
+} /* }}} */
+
+/* Releases a document returned by php_phongo_bson_scratch_begin(). The scratch
+ * buffer is rewound so that the next document reuses it from the start, unless
+ * it has grown too large to be retained. */
+void php_phongo_bson_scratch_end(bson_t* bson) /* {{{ */
+{
+	if (!bson) {
+		return;
+	}
+
+	if (MONGODB_G(bson_scratch_in_use) && MONGODB_G(bson_scratch_buf) && bson_get_data(bson) == MONGODB_G(bson_scratch_buf)) {
+		bson_writer_rollback(MONGODB_G(bson_scratch));
+		MONGODB_G(bson_scratch_in_use) = false;
+
+		if (MONGODB_G(bson_scratch_buf_len) > PHONGO_BSON_SCRATCH_MAX_RETAINED_SIZE) {
+			php_phongo_bson_scratch_free();
+		}
+
+		return;
+	}
+
+	bson_destroy(bson);
+} /* }}} */
+
+void php_phongo_bson_scratch_free(void) /* {{{ */
+{
+	if (MONGODB_G(bson_scratch)) {
+		bson_writer_destroy(MONGODB_G(bson_scratch));
+		MONGODB_G(bson_scratch) = NULL;
+	}
+
+	if (MONGODB_G(bson_scratch_buf)) {
+		efree(MONGODB_G(bson_scratch_buf));
+		MONGODB_G(bson_scratch_buf)     = NULL;
+		MONGODB_G(bson_scratch_buf_len) = 0;
+	}
+
+	MONGODB_G(bson_scratch_in_use) = false;
+} /* }}} */
+
 /* Converts the array or object argument to a BSON document. If the object is an
  * instance of MongoDB\BSON\Serializable, the return value of bsonSerialize()
  * will be used. */
@@ -487,7 +976,9 @@ void php_phongo_zval_to_bson(zval* data, php_phongo_bson_flags_t flags, bson_t*
 {
 	php_phongo_field_path* field_path = php_phongo_field_path_alloc(false);
 
+	PHONGO_PROBE(bson__encode__start);
 	php_phongo_zval_to_bson_internal(data, field_path, flags, bson, bson_out);
+	PHONGO_PROBE1(bson__encode__done, bson->len);
 
 	php_phongo_field_path_free(field_path);
 } /* }}} */
@@ -27,6 +27,19 @@ typedef enum {
 	PHONGO_BSON_RETURN_ID = 0x02
 } php_phongo_bson_flags_t;
 
+void php_phongo_bson_encode_types_init(void);
+void php_phongo_bson_encode_types_dtor(void);
+void php_phongo_bson_property_map_dtor(zval* zv);
+
+/* Largest size to which the scratch buffer is grown up front or retained
+ * between documents (see php_phongo_bson_scratch_begin()) */
+#define PHONGO_BSON_SCRATCH_MAX_RETAINED_SIZE (4 * 1024 * 1024)
+
+void*   php_phongo_bson_erealloc(void* mem, size_t num_bytes, void* ctx);
+bson_t* php_phongo_bson_scratch_begin(size_t size_hint);
+void    php_phongo_bson_scratch_end(bson_t* bson);
+void    php_phongo_bson_scratch_free(void);
+
 void php_phongo_zval_to_bson(zval* data, php_phongo_bson_flags_t flags, bson_t* bson, bson_t** bson_out);
 void php_phongo_zval_to_bson_value(zval* data, php_phongo_bson_flags_t flags, bson_value_t* value);
 
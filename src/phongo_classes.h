@@ -107,10 +107,18 @@ static inline php_phongo_decimal128_t* php_decimal128_fetch_object(zend_object*
 {
 	return (php_phongo_decimal128_t*) ((char*) obj - XtOffsetOf(php_phongo_decimal128_t, std));
 }
+static inline php_phongo_document_t* php_document_fetch_object(zend_object* obj)
+{
+	return (php_phongo_document_t*) ((char*) obj - XtOffsetOf(php_phongo_document_t, std));
+}
 static inline php_phongo_int64_t* php_int64_fetch_object(zend_object* obj)
 {
 	return (php_phongo_int64_t*) ((char*) obj - XtOffsetOf(php_phongo_int64_t, std));
 }
+static inline php_phongo_iterator_t* php_iterator_fetch_object(zend_object* obj)
+{
+	return (php_phongo_iterator_t*) ((char*) obj - XtOffsetOf(php_phongo_iterator_t, std));
+}
 static inline php_phongo_javascript_t* php_javascript_fetch_object(zend_object* obj)
 {
 	return (php_phongo_javascript_t*) ((char*) obj - XtOffsetOf(php_phongo_javascript_t, std));
@@ -127,10 +135,22 @@ static inline php_phongo_objectid_t* php_objectid_fetch_object(zend_object* obj)
 {
 	return (php_phongo_objectid_t*) ((char*) obj - XtOffsetOf(php_phongo_objectid_t, std));
 }
+static inline php_phongo_packedarray_t* php_packedarray_fetch_object(zend_object* obj)
+{
+	return (php_phongo_packedarray_t*) ((char*) obj - XtOffsetOf(php_phongo_packedarray_t, std));
+}
 static inline php_phongo_regex_t* php_regex_fetch_object(zend_object* obj)
 {
 	return (php_phongo_regex_t*) ((char*) obj - XtOffsetOf(php_phongo_regex_t, std));
 }
+static inline php_phongo_sequencereader_t* php_sequencereader_fetch_object(zend_object* obj)
+{
+	return (php_phongo_sequencereader_t*) ((char*) obj - XtOffsetOf(php_phongo_sequencereader_t, std));
+}
+static inline php_phongo_sequencewriter_t* php_sequencewriter_fetch_object(zend_object* obj)
+{
+	return (php_phongo_sequencewriter_t*) ((char*) obj - XtOffsetOf(php_phongo_sequencewriter_t, std));
+}
 static inline php_phongo_symbol_t* php_symbol_fetch_object(zend_object* obj)
 {
 	return (php_phongo_symbol_t*) ((char*) obj - XtOffsetOf(php_phongo_symbol_t, std));
@@ -217,12 +237,17 @@ static inline php_phongo_topologyopeningevent_t* php_topologyopeningevent_fetch_
 #define Z_BINARY_OBJ_P(zv) (php_binary_fetch_object(Z_OBJ_P(zv)))
 #define Z_DBPOINTER_OBJ_P(zv) (php_dbpointer_fetch_object(Z_OBJ_P(zv)))
 #define Z_DECIMAL128_OBJ_P(zv) (php_decimal128_fetch_object(Z_OBJ_P(zv)))
+#define Z_DOCUMENT_OBJ_P(zv) (php_document_fetch_object(Z_OBJ_P(zv)))
 #define Z_INT64_OBJ_P(zv) (php_int64_fetch_object(Z_OBJ_P(zv)))
+#define Z_ITERATOR_OBJ_P(zv) (php_iterator_fetch_object(Z_OBJ_P(zv)))
 #define Z_JAVASCRIPT_OBJ_P(zv) (php_javascript_fetch_object(Z_OBJ_P(zv)))
 #define Z_MAXKEY_OBJ_P(zv) (php_maxkey_fetch_object(Z_OBJ_P(zv)))
 #define Z_MINKEY_OBJ_P(zv) (php_minkey_fetch_object(Z_OBJ_P(zv)))
 #define Z_OBJECTID_OBJ_P(zv) (php_objectid_fetch_object(Z_OBJ_P(zv)))
+#define Z_PACKEDARRAY_OBJ_P(zv) (php_packedarray_fetch_object(Z_OBJ_P(zv)))
 #define Z_REGEX_OBJ_P(zv) (php_regex_fetch_object(Z_OBJ_P(zv)))
+#define Z_SEQUENCEREADER_OBJ_P(zv) (php_sequencereader_fetch_object(Z_OBJ_P(zv)))
+#define Z_SEQUENCEWRITER_OBJ_P(zv) (php_sequencewriter_fetch_object(Z_OBJ_P(zv)))
 #define Z_SYMBOL_OBJ_P(zv) (php_symbol_fetch_object(Z_OBJ_P(zv)))
 #define Z_TIMESTAMP_OBJ_P(zv) (php_timestamp_fetch_object(Z_OBJ_P(zv)))
 #define Z_UNDEFINED_OBJ_P(zv) (php_undefined_fetch_object(Z_OBJ_P(zv)))
@@ -261,12 +286,17 @@ static inline php_phongo_topologyopeningevent_t* php_topologyopeningevent_fetch_
 #define Z_OBJ_BINARY(zo) (php_binary_fetch_object(zo))
 #define Z_OBJ_DBPOINTER(zo) (php_dbpointer_fetch_object(zo))
 #define Z_OBJ_DECIMAL128(zo) (php_decimal128_fetch_object(zo))
+#define Z_OBJ_DOCUMENT(zo) (php_document_fetch_object(zo))
 #define Z_OBJ_INT64(zo) (php_int64_fetch_object(zo))
+#define Z_OBJ_ITERATOR(zo) (php_iterator_fetch_object(zo))
 #define Z_OBJ_JAVASCRIPT(zo) (php_javascript_fetch_object(zo))
 #define Z_OBJ_MAXKEY(zo) (php_maxkey_fetch_object(zo))
 #define Z_OBJ_MINKEY(zo) (php_minkey_fetch_object(zo))
 #define Z_OBJ_OBJECTID(zo) (php_objectid_fetch_object(zo))
+#define Z_OBJ_PACKEDARRAY(zo) (php_packedarray_fetch_object(zo))
 #define Z_OBJ_REGEX(zo) (php_regex_fetch_object(zo))
+#define Z_OBJ_SEQUENCEREADER(zo) (php_sequencereader_fetch_object(zo))
+#define Z_OBJ_SEQUENCEWRITER(zo) (php_sequencewriter_fetch_object(zo))
 #define Z_OBJ_SYMBOL(zo) (php_symbol_fetch_object(zo))
 #define Z_OBJ_TIMESTAMP(zo) (php_timestamp_fetch_object(zo))
 #define Z_OBJ_UNDEFINED(zo) (php_undefined_fetch_object(zo))
@@ -323,17 +353,23 @@ extern zend_class_entry* php_phongo_bulkwriteexception_ce;
 
 extern zend_class_entry* php_phongo_type_ce;
 extern zend_class_entry* php_phongo_persistable_ce;
+extern zend_class_entry* php_phongo_propertycodec_ce;
 extern zend_class_entry* php_phongo_unserializable_ce;
 extern zend_class_entry* php_phongo_serializable_ce;
 extern zend_class_entry* php_phongo_binary_ce;
 extern zend_class_entry* php_phongo_dbpointer_ce;
 extern zend_class_entry* php_phongo_decimal128_ce;
+extern zend_class_entry* php_phongo_document_ce;
 extern zend_class_entry* php_phongo_int64_ce;
+extern zend_class_entry* php_phongo_iterator_ce;
 extern zend_class_entry* php_phongo_javascript_ce;
 extern zend_class_entry* php_phongo_maxkey_ce;
 extern zend_class_entry* php_phongo_minkey_ce;
 extern zend_class_entry* php_phongo_objectid_ce;
+extern zend_class_entry* php_phongo_packedarray_ce;
 extern zend_class_entry* php_phongo_regex_ce;
+extern zend_class_entry* php_phongo_sequencereader_ce;
+extern zend_class_entry* php_phongo_sequencewriter_ce;
 extern zend_class_entry* php_phongo_symbol_ce;
 extern zend_class_entry* php_phongo_timestamp_ce;
 extern zend_class_entry* php_phongo_undefined_ce;
@@ -368,13 +404,19 @@ extern zend_class_entry* php_phongo_topologyopeningevent_ce;
 extern void php_phongo_binary_init_ce(INIT_FUNC_ARGS);
 extern void php_phongo_dbpointer_init_ce(INIT_FUNC_ARGS);
 extern void php_phongo_decimal128_init_ce(INIT_FUNC_ARGS);
+extern void php_phongo_document_init_ce(INIT_FUNC_ARGS);
 extern void php_phongo_int64_init_ce(INIT_FUNC_ARGS);
+extern void php_phongo_iterator_init_ce(INIT_FUNC_ARGS);
 extern void php_phongo_javascript_init_ce(INIT_FUNC_ARGS);
 extern void php_phongo_maxkey_init_ce(INIT_FUNC_ARGS);
 extern void php_phongo_minkey_init_ce(INIT_FUNC_ARGS);
 extern void php_phongo_objectid_init_ce(INIT_FUNC_ARGS);
+extern void php_phongo_packedarray_init_ce(INIT_FUNC_ARGS);
 extern void php_phongo_persistable_init_ce(INIT_FUNC_ARGS);
+extern void php_phongo_propertycodec_init_ce(INIT_FUNC_ARGS);
 extern void php_phongo_regex_init_ce(INIT_FUNC_ARGS);
+extern void php_phongo_sequencereader_init_ce(INIT_FUNC_ARGS);
+extern void php_phongo_sequencewriter_init_ce(INIT_FUNC_ARGS);
 extern void php_phongo_serializable_init_ce(INIT_FUNC_ARGS);
 extern void php_phongo_symbol_init_ce(INIT_FUNC_ARGS);
 extern void php_phongo_timestamp_init_ce(INIT_FUNC_ARGS);
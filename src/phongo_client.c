@@ -28,6 +28,7 @@
 #include "phongo_bson_encode.h"
 #include "phongo_client.h"
 #include "phongo_error.h"
+#include "phongo_probes.h"
 #include "phongo_util.h"
 
 #include "MongoDB/ReadPreference.h"
@@ -1154,10 +1155,14 @@ static mongoc_client_t* php_phongo_make_mongo_client(const mongoc_uri_t* uri, zv
 
 	php_phongo_set_handshake_data(driverOptions);
 
+	PHONGO_PROBE(client__create__start);
+
 	if (!(client = mongoc_client_new_from_uri_with_error(uri, &error))) {
 		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT, "Failed to parse URI options: %s", error.message);
 	}
 
+	PHONGO_PROBE1(client__create__done, client != NULL);
+
 	return client;
 } /* }}} */
 
@@ -1580,6 +1585,7 @@ cleanup:
 static void phongo_pclient_reset_once(php_phongo_pclient_t* pclient, int pid)
 {
 	if (pclient->last_reset_by_pid != pid) {
+		PHONGO_PROBE1(client__reset, pid);
 		mongoc_client_reset(pclient->client);
 		pclient->last_reset_by_pid = pid;
 	}
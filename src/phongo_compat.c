@@ -44,6 +44,24 @@ zend_bool php_phongo_zend_hash_apply_protection_end(HashTable* ht)
 	}
 	return 1;
 }
+
+zend_bool php_phongo_zend_object_apply_protection_begin(zval* object)
+{
+	if (Z_OBJ_APPLY_COUNT_P(object) > 0) {
+		return 0;
+	}
+	Z_OBJ_INC_APPLY_COUNT_P(object);
+	return 1;
+}
+
+zend_bool php_phongo_zend_object_apply_protection_end(zval* object)
+{
+	if (Z_OBJ_APPLY_COUNT_P(object) == 0) {
+		return 0;
+	}
+	Z_OBJ_DEC_APPLY_COUNT_P(object);
+	return 1;
+}
 #else /* PHP 7.3 or later */
 zend_bool php_phongo_zend_hash_apply_protection_begin(zend_array* ht)
 {
@@ -66,4 +84,22 @@ zend_bool php_phongo_zend_hash_apply_protection_end(zend_array* ht)
 	}
 	return 1;
 }
+
+zend_bool php_phongo_zend_object_apply_protection_begin(zval* object)
+{
+	if (Z_IS_RECURSIVE_P(object)) {
+		return 0;
+	}
+	Z_PROTECT_RECURSION_P(object);
+	return 1;
+}
+
+zend_bool php_phongo_zend_object_apply_protection_end(zval* object)
+{
+	if (!Z_IS_RECURSIVE_P(object)) {
+		return 0;
+	}
+	Z_UNPROTECT_RECURSION_P(object);
+	return 1;
+}
 #endif
@@ -38,6 +38,21 @@
 #define HASH_KEY_NON_EXISTENT HASH_KEY_NON_EXISTANT
 #endif
 
+#if PHP_VERSION_ID >= 80400
+#include <Zend/zend_lazy_objects.h>
+#define PHONGO_OBJ_IS_LAZY(obj) zend_object_is_lazy(obj)
+#else
+#define PHONGO_OBJ_IS_LAZY(obj) false
+#endif
+
+#ifndef HT_IS_PACKED
+#define HT_IS_PACKED(ht) (((ht)->u.flags & HASH_FLAG_PACKED) != 0)
+#endif
+
+#ifndef HT_IS_WITHOUT_HOLES
+#define HT_IS_WITHOUT_HOLES(ht) ((ht)->nNumUsed == (ht)->nNumOfElements)
+#endif
+
 #if defined(__GNUC__)
 #define ARG_UNUSED __attribute__((unused))
 #else
@@ -83,6 +98,7 @@
 
 #if PHP_VERSION_ID < 70300
 #define zend_object_alloc(obj_size, ce) ecalloc(1, obj_size + zend_object_properties_size(ce))
+#define zend_hash_real_init_packed(ht) zend_hash_real_init((ht), 1)
 #endif
 
 #define ADD_ASSOC_STRING(_zv, _key, _value) add_assoc_string_ex(_zv, ZEND_STRL(_key), (char*) (_value));
@@ -254,4 +270,9 @@ static inline zend_bool zend_ini_parse_bool(zend_string* str)
 zend_bool php_phongo_zend_hash_apply_protection_begin(HashTable* ht);
 zend_bool php_phongo_zend_hash_apply_protection_end(HashTable* ht);
 
+/* Recursion protection for objects whose property table is never built (e.g.
+ * MongoDB\BSON\PropertyCodec instances encoded from their slots) */
+zend_bool php_phongo_zend_object_apply_protection_begin(zval* object);
+zend_bool php_phongo_zend_object_apply_protection_end(zval* object);
+
 #endif /* PHONGO_COMPAT_H */
@@ -25,6 +25,7 @@
 #include "php_phongo.h"
 #include "phongo_error.h"
 #include "phongo_execute.h"
+#include "phongo_probes.h"
 #include "phongo_util.h"
 
 #include "MongoDB/Cursor.h"
@@ -339,8 +340,10 @@ bool phongo_execute_bulk_write(zval* manager, const char* namespace, php_phongo_
 		mongoc_bulk_operation_set_write_concern(bulk, Z_WRITECONCERN_OBJ_P(zwriteConcern)->write_concern);
 	}
 
+	PHONGO_PROBE1(bulk__write__start, namespace);
 	success              = mongoc_bulk_operation_execute(bulk, &reply, &error);
 	bulk_write->executed = true;
+	PHONGO_PROBE1(bulk__write__done, success != 0);
 
 	writeresult                = phongo_writeresult_init(return_value, &reply, manager, mongoc_bulk_operation_get_hint(bulk));
 	writeresult->write_concern = mongoc_write_concern_copy(write_concern);
@@ -466,6 +469,8 @@ bool phongo_execute_command(zval* manager, php_phongo_command_type_t type, const
 	/* Although "opts" already always includes the serverId option, the read
 	 * preference is added to the command parts, which is relevant for mongos
 	 * command construction. */
+	PHONGO_PROBE2(command__start, db, (int) type);
+
 	switch (type) {
 		case PHONGO_COMMAND_RAW:
 			result = mongoc_client_command_with_opts(client, db, command->bson, phongo_read_preference_from_zval(zreadPreference), &opts, &reply, &error);
@@ -483,9 +488,12 @@ bool phongo_execute_command(zval* manager, php_phongo_command_type_t type, const
 		default:
 			/* Should never happen, but if it does: exception */
 			phongo_throw_exception(PHONGO_ERROR_LOGIC, "Type '%d' should never have been passed to phongo_execute_command, please file a bug report", type);
+			PHONGO_PROBE1(command__done, false);
 			goto cleanup;
 	}
 
+	PHONGO_PROBE1(command__done, result);
+
 	free_reply = true;
 
 	if (!result) {
@@ -606,6 +614,8 @@ bool phongo_execute_query(zval* manager, const char* namespace, zval* zquery, zv
 		return false;
 	}
 
+	PHONGO_PROBE1(query__start, namespace);
+
 	cursor = mongoc_collection_find_with_opts(collection, query->filter, &opts, phongo_read_preference_from_zval(zreadPreference));
 	mongoc_collection_destroy(collection);
 	bson_destroy(&opts);
@@ -616,10 +626,13 @@ bool phongo_execute_query(zval* manager, const char* namespace, zval* zquery, zv
 	}
 
 	if (!phongo_cursor_advance_and_check_for_error(cursor)) {
+		PHONGO_PROBE1(query__done, false);
 		mongoc_cursor_destroy(cursor);
 		return false;
 	}
 
+	PHONGO_PROBE1(query__done, true);
+
 	phongo_cursor_init_for_query(return_value, manager, cursor, namespace, zquery, zreadPreference, zsession);
 
 	return true;
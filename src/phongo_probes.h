@@ -0,0 +1,78 @@
+/*
+ * Copyright 2022-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PHONGO_PROBES_H
+#define PHONGO_PROBES_H
+
+/* Static tracepoints (USDT) on the driver's hot paths. These are only compiled
+ * in when configured with --enable-mongodb-probes, which requires sys/sdt.h
+ * (e.g. from systemtap-sdt-devel). Otherwise, they expand to nothing. An
+ * enabled probe is a single nop instruction until a tracer such as bpftrace or
+ * perf attaches to it, e.g.:
+ *
+ *   bpftrace -e 'usdt:/path/to/mongodb.so:mongodb:command__start { ... }'
+ *
+ * Each phase has a start and done probe so that its latency can be measured:
+ *
+ *   bson__encode__start(), bson__encode__done(uint32_t length)
+ *   bson__decode__start(uint32_t length), bson__decode__done(bool success)
+ *   command__start(const char* db, int type), command__done(bool success)
+ *   query__start(const char* namespace), query__done(bool success)
+ *   bulk__write__start(const char* namespace), bulk__write__done(bool success)
+ *   cursor__next__start(int64_t cursor_id), cursor__next__done(bool has_document)
+ *   client__create__start(), client__create__done(bool success)
+ *   client__reset(int pid)
+ *
+ * cursor__next spans any getMore command issued for the next batch. */
+#ifdef PHONGO_HAVE_PROBES
+/* Probes are built with semaphores, which a tracer increments while attached.
+ * Probe arguments that are not free to compute should be guarded with
+ * PHONGO_PROBE_ENABLED(). The semaphores are defined in php_phongo.c. */
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+#define PHONGO_PROBE_NAMES(X)  \
+	X(bson__encode__start)     \
+	X(bson__encode__done)      \
+	X(bson__decode__start)     \
+	X(bson__decode__done)      \
+	X(command__start)          \
+	X(command__done)           \
+	X(query__start)            \
+	X(query__done)             \
+	X(bulk__write__start)      \
+	X(bulk__write__done)       \
+	X(cursor__next__start)     \
+	X(cursor__next__done)      \
+	X(client__create__start)   \
+	X(client__create__done)    \
+	X(client__reset)
+
+#define PHONGO_PROBE_DECLARE_SEMAPHORE(name) extern unsigned short mongodb_##name##_semaphore;
+PHONGO_PROBE_NAMES(PHONGO_PROBE_DECLARE_SEMAPHORE)
+
+#define PHONGO_PROBE_ENABLED(name) __builtin_expect(mongodb_##name##_semaphore, 0)
+#define PHONGO_PROBE(name) DTRACE_PROBE(mongodb, name)
+#define PHONGO_PROBE1(name, a1) DTRACE_PROBE1(mongodb, name, a1)
+#define PHONGO_PROBE2(name, a1, a2) DTRACE_PROBE2(mongodb, name, a1, a2)
+#else /* PHONGO_HAVE_PROBES */
+#define PHONGO_PROBE_ENABLED(name) 0
+#define PHONGO_PROBE(name)
+#define PHONGO_PROBE1(name, a1)
+#define PHONGO_PROBE2(name, a1, a2)
+#endif /* PHONGO_HAVE_PROBES */
+
+#endif /* PHONGO_PROBES_H */
@@ -31,6 +31,7 @@ typedef struct {
 	int                      bypass;
 	bson_t*                  let;
 	bson_value_t*            comment;
+	size_t                   size_hint;
 	char*                    database;
 	char*                    collection;
 	bool                     executed;
@@ -169,11 +170,10 @@ typedef struct {
 } php_phongo_writeresult_t;
 
 typedef struct {
-	char*       data;
-	int         data_len;
-	uint8_t     type;
-	HashTable*  properties;
-	zend_object std;
+	zend_string* data;
+	uint8_t      type;
+	HashTable*   properties;
+	zend_object  std;
 } php_phongo_binary_t;
 
 typedef struct {
@@ -191,6 +191,12 @@ typedef struct {
 	zend_object       std;
 } php_phongo_decimal128_t;
 
+typedef struct {
+	bson_t*     bson;
+	HashTable*  properties;
+	zend_object std;
+} php_phongo_document_t;
+
 typedef struct {
 	bool        initialized;
 	int64_t     integer;
@@ -198,6 +204,17 @@ typedef struct {
 	zend_object std;
 } php_phongo_int64_t;
 
+typedef struct {
+	zval        bson;
+	bson_iter_t iter;
+	bool        valid;
+	bool        is_array;
+	size_t      key;
+	zval        current;
+	HashTable*  properties;
+	zend_object std;
+} php_phongo_iterator_t;
+
 typedef struct {
 	char*       code;
 	size_t      code_len;
@@ -216,11 +233,17 @@ typedef struct {
 
 typedef struct {
 	bool        initialized;
-	char        oid[25];
+	bson_oid_t  oid;
 	HashTable*  properties;
 	zend_object std;
 } php_phongo_objectid_t;
 
+typedef struct {
+	bson_t*     bson;
+	HashTable*  properties;
+	zend_object std;
+} php_phongo_packedarray_t;
+
 typedef struct {
 	char*       pattern;
 	int         pattern_len;
@@ -230,6 +253,28 @@ typedef struct {
 	zend_object std;
 } php_phongo_regex_t;
 
+typedef struct {
+	bson_reader_t*        reader;
+	zval                  stream;
+	int64_t               bytes_read;
+	bool                  started;
+	zend_long             key;
+	php_phongo_bson_state visitor_data;
+	zend_object           std;
+} php_phongo_sequencereader_t;
+
+typedef struct {
+	bson_writer_t* writer;
+	uint8_t*       buf;
+	size_t         buf_len;
+	size_t         buffer_size;
+	size_t         written;
+	bool           in_write;
+	bool           flush_failed;
+	zval           stream;
+	zend_object    std;
+} php_phongo_sequencewriter_t;
+
 typedef struct {
 	char*       symbol;
 	size_t      symbol_len;
@@ -19,6 +19,11 @@
 
 #include <php.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PHONGO_HAVE_SSE2 1
+#endif
+
 #include "phongo_util.h"
 
 /* If options is not an array, insert it as a field in a newly allocated array.
@@ -70,6 +75,79 @@ bool php_phongo_parse_int64(int64_t* retval, const char* data, size_t data_len)
 	return true;
 } /* }}} */
 
+/* Returns the length of the run of ASCII bytes at the start of data. SSE2 is
+ * part of the x86-64 baseline, so no runtime CPU detection is needed to use it.
+ * Other platforms test eight bytes at a time. */
+static size_t php_phongo_utf8_ascii_len(const char* data, size_t data_len) /* {{{ */
+{
+	size_t i = 0;
+
+#ifdef PHONGO_HAVE_SSE2
+	for (; i + sizeof(__m128i) <= data_len; i += sizeof(__m128i)) {
+		if (_mm_movemask_epi8(_mm_loadu_si128((const __m128i*) (data + i)))) {
+			break;
+		}
+	}
+#endif
+
+	for (; i + sizeof(uint64_t) <= data_len; i += sizeof(uint64_t)) {
+		uint64_t word;
+
+		memcpy(&word, data + i, sizeof(word));
+
+		if (word & UINT64_C(0x8080808080808080)) {
+			break;
+		}
+	}
+
+	while (i < data_len && !((unsigned char) data[i] & 0x80)) {
+		i++;
+	}
+
+	return i;
+} /* }}} */
+
+/* Validates UTF-8 with the same rules as bson_utf8_validate(), which inspects
+ * one byte at a time. Runs of ASCII are skipped in bulk and only the runs of
+ * non-ASCII bytes between them are handed to libbson. A multi-byte sequence
+ * never contains an ASCII byte, so a valid sequence always lies within a
+ * single run and a sequence cut short by an ASCII byte fails validation. */
+bool php_phongo_utf8_validate(const char* data, size_t data_len, bool allow_null) /* {{{ */
+{
+	size_t i = 0;
+
+	while (i < data_len) {
+		size_t ascii_len = php_phongo_utf8_ascii_len(data + i, data_len - i);
+		size_t run_len   = 0;
+
+		if (!allow_null && ascii_len && memchr(data + i, '\0', ascii_len)) {
+			return false;
+		}
+
+		i += ascii_len;
+
+		while (i + run_len < data_len && ((unsigned char) data[i + run_len] & 0x80)) {
+			run_len++;
+		}
+
+		if (run_len && !bson_utf8_validate(data + i, run_len, allow_null)) {
+			return false;
+		}
+
+		i += run_len;
+	}
+
+	return true;
+} /* }}} */
+
+/* Returns the stream for a resource, or NULL if the resource is not a stream or
+ * has been closed (e.g. with fclose()). Unlike php_stream_from_zval(), no
+ * warning is emitted. */
+php_stream* php_phongo_stream_from_zval(zval* zstream) /* {{{ */
+{
+	return (php_stream*) zend_fetch_resource2(Z_RES_P(zstream), NULL, php_file_le_stream(), php_file_le_pstream());
+} /* }}} */
+
 /* Splits a namespace name into the database and collection names, allocated with estrdup. */
 bool phongo_split_namespace(const char* namespace, char** dbname, char** cname) /* {{{ */
 {
@@ -22,6 +22,10 @@ void  php_phongo_prep_legacy_option_free(zval* options);
 
 bool php_phongo_parse_int64(int64_t* retval, const char* data, size_t data_len);
 
+bool php_phongo_utf8_validate(const char* data, size_t data_len, bool allow_null);
+
+php_stream* php_phongo_stream_from_zval(zval* zstream);
+
 bool phongo_split_namespace(const char* namespace, char** dbname, char** cname);
 
 #endif /* PHONGO_UTIL_H */
@@ -0,0 +1,42 @@
+--TEST--
+MongoDB\BSON\Binary shares its data with the strings it is created from and returns
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+$data = str_repeat("\x00\xff", 1024 * 1024);
+$binary = new MongoDB\BSON\Binary($data, MongoDB\BSON\Binary::TYPE_GENERIC);
+
+var_dump($binary->getData() === $data);
+var_dump((string) $binary === $data);
+
+/* Clones and unserialized objects are independent of the original */
+$clone = clone $binary;
+var_dump($clone == $binary, $clone->getData() === $data);
+var_dump(unserialize(serialize($binary)) == $binary);
+
+/* Decoded payloads survive the BSON string they were read from */
+$bson = fromPHP(['x' => $binary]);
+$decoded = toPHP($bson)->x;
+unset($bson);
+var_dump($decoded == $binary, strlen($decoded->getData()));
+
+/* Reinitializing the object releases the previous data */
+$binary->__unserialize(['data' => 'foo', 'type' => 0]);
+var_dump($binary->getData(), $clone->getData() === $data);
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+int(2097152)
+string(3) "foo"
+bool(true)
+===DONE===
@@ -0,0 +1,51 @@
+--TEST--
+MongoDB\BSON\Binary::fromVector() and toArray()
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+$vectors = [
+    [[1.5, -2, 0.25], MongoDB\BSON\Binary::VECTOR_TYPE_FLOAT32],
+    [[127, -128, 0], MongoDB\BSON\Binary::VECTOR_TYPE_INT8],
+    [[1, 0, true, 1, false, 0, 0, 0, 1], MongoDB\BSON\Binary::VECTOR_TYPE_PACKED_BIT],
+    [[], MongoDB\BSON\Binary::VECTOR_TYPE_PACKED_BIT],
+];
+
+foreach ($vectors as [$vector, $vectorType]) {
+    $binary = MongoDB\BSON\Binary::fromVector($vector, $vectorType);
+
+    var_dump($binary->getType() === MongoDB\BSON\Binary::TYPE_VECTOR);
+    var_dump($binary->getVectorType() === $vectorType);
+    echo bin2hex($binary->getData()), "\n";
+    echo json_encode($binary->toArray()), "\n";
+
+    /* Vectors survive a BSON round trip */
+    var_dump(toPHP(fromPHP(['v' => $binary]))->v == $binary);
+}
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+bool(true)
+bool(true)
+27000000c03f000000c00000803e
+[1.5,-2.0,0.25]
+bool(true)
+bool(true)
+bool(true)
+03007f8000
+[127,-128,0]
+bool(true)
+bool(true)
+bool(true)
+1007b080
+[1,0,1,1,0,0,0,0,1]
+bool(true)
+bool(true)
+bool(true)
+1000
+[]
+bool(true)
+===DONE===
@@ -0,0 +1,69 @@
+--TEST--
+MongoDB\BSON\Binary vector errors
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+$invalidVectors = [
+    [[1.0], 0x42],
+    [[1 => 1.0], MongoDB\BSON\Binary::VECTOR_TYPE_FLOAT32],
+    [['1.0'], MongoDB\BSON\Binary::VECTOR_TYPE_FLOAT32],
+    [[128], MongoDB\BSON\Binary::VECTOR_TYPE_INT8],
+    [[0, 2], MongoDB\BSON\Binary::VECTOR_TYPE_PACKED_BIT],
+];
+
+foreach ($invalidVectors as [$vector, $vectorType]) {
+    echo throws(function() use ($vector, $vectorType) {
+        MongoDB\BSON\Binary::fromVector($vector, $vectorType);
+    }, 'MongoDB\Driver\Exception\InvalidArgumentException'), "\n";
+}
+
+echo throws(function() {
+    (new MongoDB\BSON\Binary('foo', MongoDB\BSON\Binary::TYPE_GENERIC))->toArray();
+}, 'MongoDB\Driver\Exception\LogicException'), "\n";
+
+$invalidData = [
+    "\x27",
+    "\x27\x00\x00\x00\x00",
+    "\x03\x01\x00",
+    "\x10\x08\x00",
+    "\x10\x01",
+    "\x42\x00",
+];
+
+foreach ($invalidData as $data) {
+    echo throws(function() use ($data) {
+        (new MongoDB\BSON\Binary($data, MongoDB\BSON\Binary::TYPE_VECTOR))->toArray();
+    }, 'MongoDB\Driver\Exception\UnexpectedValueException'), "\n";
+}
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+Expected vector type to be one of the VECTOR_TYPE_* constants, 66 given
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+Expected vector to be a list, but given array is not
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+Expected vector element 0 to be a float or integer, string given
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+Expected vector element 0 to be an integer between -128 and 127
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+Expected vector element 1 to be a boolean, 0, or 1
+OK: Got MongoDB\Driver\Exception\LogicException
+Expected Binary of type vector (9), 0 given
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Binary vector data is malformed
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Binary vector data is malformed
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Binary vector data is malformed
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Binary vector data is malformed
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Binary vector data is malformed
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Unsupported vector type: 0x42
+===DONE===
@@ -0,0 +1,51 @@
+--TEST--
+MongoDB\BSON\Document accesses fields without decoding the entire document
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+$document = MongoDB\BSON\Document::fromPHP(['foo' => 'bar', 'nested' => ['x' => 1], 'list' => [1, 2]]);
+
+var_dump($document->has('foo'));
+var_dump($document->has('bar'));
+var_dump($document->get('foo'));
+var_dump($document->get('nested'));
+var_dump($document->get('list'));
+
+foreach ($document as $key => $value) {
+    printf("%s: %s\n", $key, is_object($value) ? get_class($value) : gettype($value));
+}
+
+var_dump($document->get('nested')->toPHP());
+var_dump($document->toPHP(['root' => 'array', 'array' => 'bson'])['list'] instanceof MongoDB\BSON\PackedArray);
+
+var_dump((string) MongoDB\BSON\Document::fromBSON((string) $document) === (string) $document);
+var_dump(toJSON((string) MongoDB\BSON\Document::fromJSON('{ "foo": "bar" }')));
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECTF--
+bool(true)
+bool(false)
+string(3) "bar"
+object(MongoDB\BSON\Document)#%d (%d) {
+  ["data"]=>
+  string(16) "DAAAABB4AAEAAAAA"
+}
+object(MongoDB\BSON\PackedArray)#%d (%d) {
+  ["data"]=>
+  string(28) "EwAAABAwAAEAAAAQMQACAAAAAA=="
+}
+foo: string
+nested: MongoDB\BSON\Document
+list: MongoDB\BSON\PackedArray
+object(stdClass)#%d (%d) {
+  ["x"]=>
+  int(1)
+}
+bool(true)
+bool(true)
+string(17) "{ "foo" : "bar" }"
+===DONE===
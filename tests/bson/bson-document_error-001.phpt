@@ -0,0 +1,40 @@
+--TEST--
+MongoDB\BSON\Document errors
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+$document = MongoDB\BSON\Document::fromPHP(['foo' => 'bar']);
+
+echo throws(function() use ($document) {
+    $document->get('bar');
+}, MongoDB\Driver\Exception\RuntimeException::class), "\n";
+
+echo throws(function() {
+    MongoDB\BSON\Document::fromBSON(substr(fromPHP(['foo' => 'bar']), 0, -1));
+}, MongoDB\Driver\Exception\UnexpectedValueException::class), "\n";
+
+echo throws(function() {
+    MongoDB\BSON\Document::fromBSON(pack('VCa*xVa*xx', 18, 2, 'foo', 10, 'bar'));
+}, MongoDB\Driver\Exception\UnexpectedValueException::class), "\n";
+
+echo throws(function() use ($document) {
+    $iterator = $document->getIterator();
+    $iterator->next();
+    $iterator->current();
+}, MongoDB\Driver\Exception\LogicException::class), "\n";
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECTF--
+OK: Got MongoDB\Driver\Exception\RuntimeException
+Could not find key "bar" in BSON document
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Could not read document from BSON reader
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected corrupt BSON data at offset %d
+OK: Got MongoDB\Driver\Exception\LogicException
+Cannot call current() on an exhausted iterator
+===DONE===
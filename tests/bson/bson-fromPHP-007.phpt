@@ -0,0 +1,57 @@
+--TEST--
+MongoDB\BSON\fromPHP(): Encoding of objects is consistent when classes are reused
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+class MySerializable implements MongoDB\BSON\Serializable
+{
+    public function bsonSerialize()
+    {
+        return ['x' => 1];
+    }
+}
+
+class MyPersistable implements MongoDB\BSON\Persistable
+{
+    public function bsonSerialize()
+    {
+        return ['y' => 2];
+    }
+
+    public function bsonUnserialize(array $data)
+    {
+    }
+}
+
+class MyType implements MongoDB\BSON\Type
+{
+}
+
+$document = [
+    'serializable' => new MySerializable,
+    'persistable' => new MyPersistable,
+    'stdClass' => (object) ['z' => 3],
+    'int64' => new MongoDB\BSON\Int64(4),
+    'maxKey' => new MongoDB\BSON\MaxKey,
+];
+
+/* Encode twice to exercise the cached encoding types */
+for ($i = 0; $i < 2; $i++) {
+    echo toJSON(fromPHP($document)), "\n";
+}
+
+echo throws(function() {
+    fromPHP(['type' => new MyType]);
+}, 'MongoDB\Driver\Exception\UnexpectedValueException'), "\n";
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+{ "serializable" : { "x" : 1 }, "persistable" : { "__pclass" : { "$binary" : "TXlQZXJzaXN0YWJsZQ==", "$type" : "80" }, "y" : 2 }, "stdClass" : { "z" : 3 }, "int64" : 4, "maxKey" : { "$maxKey" : 1 } }
+{ "serializable" : { "x" : 1 }, "persistable" : { "__pclass" : { "$binary" : "TXlQZXJzaXN0YWJsZQ==", "$type" : "80" }, "y" : 2 }, "stdClass" : { "z" : 3 }, "int64" : 4, "maxKey" : { "$maxKey" : 1 } }
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Unexpected MongoDB\BSON\Type instance: MyType
+===DONE===
@@ -0,0 +1,46 @@
+--TEST--
+MongoDB\BSON\fromPHP(): UTF-8 validation of ASCII, mixed and invalid strings
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+$ascii = str_repeat('abcdefgh', 5);
+
+$tests = [
+    'empty'                          => '',
+    'ASCII'                          => $ascii,
+    'ASCII with NUL'                 => $ascii . "\0" . $ascii,
+    'two-byte after ASCII'           => $ascii . "\xC3\xA9",
+    'mixed'                          => $ascii . "\xC3\xA9" . $ascii . "\xE2\x82\xAC\xF0\x9F\x98\x80" . $ascii,
+    'continuation byte after ASCII'  => $ascii . "\x80" . $ascii,
+    'sequence cut short by ASCII'    => $ascii . "\xE2\x82" . $ascii,
+    'truncated sequence at the end'  => $ascii . "\xF0\x9F\x98",
+    'overlong encoding'              => $ascii . "\xE0\x80\xAF",
+    'invalid lead byte'              => $ascii . "\xFF",
+];
+
+foreach ($tests as $name => $value) {
+    try {
+        $bson = fromPHP(['x' => $value]);
+        printf("%s: %s\n", $name, toPHP($bson)->x === $value ? 'valid' : 'mismatch');
+    } catch (MongoDB\Driver\Exception\UnexpectedValueException $e) {
+        printf("%s: invalid\n", $name);
+    }
+}
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+empty: valid
+ASCII: valid
+ASCII with NUL: valid
+two-byte after ASCII: valid
+mixed: valid
+continuation byte after ASCII: invalid
+sequence cut short by ASCII: invalid
+truncated sequence at the end: invalid
+overlong encoding: invalid
+invalid lead byte: invalid
+===DONE===
@@ -0,0 +1,53 @@
+--TEST--
+MongoDB\BSON\fromPHP(): PHP arrays are encoded as BSON arrays only if their keys are sequential
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+$packed = [1, 2, 3];
+
+$holeInMiddle = $packed;
+unset($holeInMiddle[1]);
+
+$holeAtEnd = $packed;
+unset($holeAtEnd[2]);
+
+$holeAtStart = $packed;
+unset($holeAtStart[0]);
+
+$reindexed = array_values($holeInMiddle);
+
+$outOfOrder = [1 => 'b', 0 => 'a'];
+
+$stringKey = $packed;
+$stringKey['x'] = 4;
+
+$tests = [
+    'packed'         => $packed,
+    'hole in middle' => $holeInMiddle,
+    'hole at end'    => $holeAtEnd,
+    'hole at start'  => $holeAtStart,
+    'reindexed'      => $reindexed,
+    'out of order'   => $outOfOrder,
+    'string key'     => $stringKey,
+    'empty'          => [],
+];
+
+foreach ($tests as $name => $value) {
+    printf("%s: %s\n", $name, toJSON(fromPHP(['x' => $value])));
+}
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+packed: { "x" : [ 1, 2, 3 ] }
+hole in middle: { "x" : { "0" : 1, "2" : 3 } }
+hole at end: { "x" : [ 1, 2 ] }
+hole at start: { "x" : { "1" : 2, "2" : 3 } }
+reindexed: { "x" : [ 1, 3 ] }
+out of order: { "x" : { "1" : "b", "0" : "a" } }
+string key: { "x" : { "0" : 1, "1" : 2, "2" : 3, "x" : 4 } }
+empty: { "x" : [  ] }
+===DONE===
@@ -0,0 +1,32 @@
+--TEST--
+MongoDB\BSON\fromPHP(): Encoding integer keys
+--SKIPIF--
+<?php if (PHP_INT_SIZE !== 8) { die('skip Only for 64-bit platform'); } ?>
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+$document = [
+    0 => 'a',
+    999 => 'b',
+    1000 => 'c',
+    4294967295 => 'd',
+    4294967296 => 'e',
+    -1 => 'f',
+    PHP_INT_MIN => 'g',
+];
+
+echo toJSON(fromPHP($document)), "\n";
+
+$list = range(0, 1500);
+$decoded = toPHP(fromPHP(['x' => $list]), ['array' => 'array']);
+var_dump($decoded->x === $list);
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+{ "0" : "a", "999" : "b", "1000" : "c", "4294967295" : "d", "4294967296" : "e", "-1" : "f", "-9223372036854775808" : "g" }
+bool(true)
+===DONE===
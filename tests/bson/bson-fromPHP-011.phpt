@@ -0,0 +1,35 @@
+--TEST--
+MongoDB\BSON\fromPHP(): Encoding documents of varying size and nested calls
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+class NestedEncoder implements MongoDB\BSON\Serializable
+{
+    public function bsonSerialize(): array
+    {
+        /* Encodes another document while the outer call is still in progress */
+        return ['inner' => bin2hex(fromPHP(['x' => 1]))];
+    }
+}
+
+/* Documents of increasing and decreasing size reuse the same buffer */
+foreach ([1, 1000, 10, 100000, 2] as $size) {
+    $document = ['s' => str_repeat('a', $size)];
+    var_dump(toPHP(fromPHP($document), ['root' => 'array']) === $document);
+}
+
+echo toJSON(fromPHP(['nested' => new NestedEncoder, 'y' => 2])), "\n";
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+{ "nested" : { "inner" : "0c0000001078000100000000" }, "y" : 2 }
+===DONE===
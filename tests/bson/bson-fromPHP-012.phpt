@@ -0,0 +1,27 @@
+--TEST--
+MongoDB\BSON\fromPHP(): Large documents do not retain the encoding buffer
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+$document = ['x' => str_repeat('a', 8 * 1024 * 1024)];
+
+$before = memory_get_usage();
+$bson = fromPHP($document);
+var_dump(strlen($bson));
+unset($bson);
+
+var_dump(memory_get_usage() - $before < 1024 * 1024);
+
+/* Small documents are still encoded after the buffer was freed */
+echo toJSON(fromPHP(['y' => 1])), "\n";
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+int(8388621)
+bool(true)
+{ "y" : 1 }
+===DONE===
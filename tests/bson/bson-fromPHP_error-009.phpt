@@ -0,0 +1,45 @@
+--TEST--
+MongoDB\BSON\fromPHP(): MongoDB\BSON\PropertyCodec documents with circular references
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+class Node implements MongoDB\BSON\PropertyCodec
+{
+    public $name;
+    public $child;
+
+    public function __construct($name)
+    {
+        $this->name = $name;
+    }
+}
+
+echo throws(function() {
+    $node = new Node('a');
+    $node->child = $node;
+    fromPHP($node);
+}, 'MongoDB\Driver\Exception\UnexpectedValueException'), "\n";
+
+echo throws(function() {
+    $node = new Node('a');
+    $node->child = new Node('b');
+    $node->child->child = $node->child;
+    fromPHP(['node' => $node]);
+}, 'MongoDB\Driver\Exception\UnexpectedValueException'), "\n";
+
+/* The same object may still appear more than once without recursion */
+$shared = new Node('shared');
+echo toJSON(fromPHP(['x' => $shared, 'y' => $shared])), "\n";
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected recursion for field path "child.child"
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected recursion for field path "node.child.child"
+{ "x" : { "name" : "shared", "child" : null }, "y" : { "name" : "shared", "child" : null } }
+===DONE===
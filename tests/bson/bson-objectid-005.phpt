@@ -0,0 +1,36 @@
+--TEST--
+MongoDB\BSON\ObjectId round-trips through BSON, clone and serialization
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+$oid = new MongoDB\BSON\ObjectId('53e2a1c40640fd72175d4603');
+
+$bson = fromPHP(['_id' => $oid]);
+echo bin2hex($bson), "\n";
+
+$decoded = toPHP($bson)->_id;
+echo $decoded, "\n";
+var_dump($decoded == $oid);
+var_dump($decoded->getTimestamp());
+echo bin2hex(fromPHP(['_id' => $decoded])) === bin2hex($bson) ? "OK\n" : "FAIL\n";
+
+$clone = clone $decoded;
+echo $clone, "\n";
+echo json_encode($clone), "\n";
+echo unserialize(serialize($clone)), "\n";
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+16000000075f69640053e2a1c40640fd72175d460300
+53e2a1c40640fd72175d4603
+bool(true)
+int(1407361476)
+OK
+53e2a1c40640fd72175d4603
+{"$oid":"53e2a1c40640fd72175d4603"}
+53e2a1c40640fd72175d4603
+===DONE===
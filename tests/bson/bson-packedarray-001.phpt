@@ -0,0 +1,77 @@
+--TEST--
+MongoDB\BSON\PackedArray accesses elements without decoding the entire array
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+$array = MongoDB\BSON\PackedArray::fromPHP(['foo', ['x' => 1], [2, 3]]);
+
+var_dump($array->has(0));
+var_dump($array->has(3));
+var_dump($array->has(-1));
+var_dump($array->get(0));
+
+foreach ($array as $key => $value) {
+    printf("%d: %s\n", $key, is_object($value) ? get_class($value) : gettype($value));
+}
+
+var_dump($array->toPHP());
+var_dump($array->toPHP(['array' => 'object', 'document' => 'array']));
+
+echo throws(function() use ($array) {
+    $array->get(3);
+}, MongoDB\Driver\Exception\RuntimeException::class), "\n";
+
+echo throws(function() {
+    MongoDB\BSON\PackedArray::fromPHP([1 => 'foo']);
+}, MongoDB\Driver\Exception\InvalidArgumentException::class), "\n";
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECTF--
+bool(true)
+bool(false)
+bool(false)
+string(3) "foo"
+0: string
+1: MongoDB\BSON\Document
+2: MongoDB\BSON\PackedArray
+array(3) {
+  [0]=>
+  string(3) "foo"
+  [1]=>
+  object(stdClass)#%d (%d) {
+    ["x"]=>
+    int(1)
+  }
+  [2]=>
+  array(2) {
+    [0]=>
+    int(2)
+    [1]=>
+    int(3)
+  }
+}
+object(stdClass)#%d (%d) {
+  ["0"]=>
+  string(3) "foo"
+  ["1"]=>
+  array(1) {
+    ["x"]=>
+    int(1)
+  }
+  ["2"]=>
+  object(stdClass)#%d (%d) {
+    ["0"]=>
+    int(2)
+    ["1"]=>
+    int(3)
+  }
+}
+OK: Got MongoDB\Driver\Exception\RuntimeException
+Could not find index 3 in BSON array
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+Expected value to be a list, but given array is not
+===DONE===
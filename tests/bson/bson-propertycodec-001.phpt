@@ -0,0 +1,65 @@
+--TEST--
+MongoDB\BSON\PropertyCodec encodes declared properties
+--SKIPIF--
+<?php require __DIR__ . "/../utils/basic-skipif.inc"; ?>
+<?php skip_if_php_version('<', '7.4.0'); ?>
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+class Address implements MongoDB\BSON\PropertyCodec
+{
+    public string $city = 'Berlin';
+}
+
+class Base implements MongoDB\BSON\PropertyCodec
+{
+    public $_id;
+    protected int $version = 1;
+}
+
+#[AllowDynamicProperties]
+class User extends Base
+{
+    public static $ignored = 'static';
+    public string $name;
+    private ?string $email = null;
+    public Address $address;
+    public array $tags = ['a', 'b'];
+    public string $uninitialized;
+}
+
+class SerializableUser implements MongoDB\BSON\PropertyCodec, MongoDB\BSON\Serializable
+{
+    public string $name = 'ignored';
+
+    public function bsonSerialize(): array
+    {
+        return ['serialized' => true];
+    }
+}
+
+$user = new User;
+$user->_id = 1;
+$user->name = 'Jane';
+$user->address = new Address;
+$user->dynamic = 'ignored';
+
+echo toJSON(fromPHP($user)), "\n";
+echo toJSON(fromPHP(['user' => $user])), "\n";
+
+unset($user->name);
+echo toJSON(fromPHP($user)), "\n";
+
+echo toJSON(fromPHP(new SerializableUser)), "\n";
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+{ "_id" : 1, "version" : 1, "name" : "Jane", "email" : null, "address" : { "city" : "Berlin" }, "tags" : [ "a", "b" ] }
+{ "user" : { "_id" : 1, "version" : 1, "name" : "Jane", "email" : null, "address" : { "city" : "Berlin" }, "tags" : [ "a", "b" ] } }
+{ "_id" : 1, "version" : 1, "email" : null, "address" : { "city" : "Berlin" }, "tags" : [ "a", "b" ] }
+{ "serialized" : true }
+===DONE===
@@ -0,0 +1,73 @@
+--TEST--
+MongoDB\BSON\PropertyCodec classes are hydrated from declared properties
+--SKIPIF--
+<?php require __DIR__ . "/../utils/basic-skipif.inc"; ?>
+<?php skip_if_php_version('<', '7.4.0'); ?>
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+class Address implements MongoDB\BSON\PropertyCodec
+{
+    public string $city;
+}
+
+class User implements MongoDB\BSON\PropertyCodec
+{
+    public static $count = 0;
+    public $_id;
+    public string $name = 'default';
+    private float $score;
+    public ?Address $address = null;
+    public string $uninitialized;
+
+    public function __construct()
+    {
+        echo "constructor called\n";
+    }
+
+    public function getScore(): float
+    {
+        return $this->score;
+    }
+}
+
+$bson = fromPHP([
+    '_id' => 1,
+    'name' => 'Jane',
+    'score' => 42,
+    'address' => ['city' => 'Berlin'],
+    'count' => 5,
+    'unknown' => 'discarded',
+]);
+
+$user = toPHP($bson, ['root' => 'User', 'fieldPaths' => ['address' => 'Address']]);
+
+var_dump($user->_id, $user->name, $user->getScore(), $user->address->city);
+var_dump(User::$count);
+var_dump(isset($user->unknown));
+var_dump(isset($user->uninitialized));
+
+echo toJSON(fromPHP($user)), "\n";
+
+try {
+    toPHP(fromPHP(['name' => ['not', 'a', 'string']]), ['root' => 'User']);
+} catch (TypeError $e) {
+    echo get_class($e), "\n";
+}
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+int(1)
+string(4) "Jane"
+float(42)
+string(6) "Berlin"
+int(0)
+bool(false)
+bool(false)
+{ "_id" : 1, "name" : "Jane", "score" : 42.0, "address" : { "city" : "Berlin" } }
+TypeError
+===DONE===
@@ -0,0 +1,48 @@
+--TEST--
+MongoDB\BSON\PropertyCodec hydrated properties behave as if assigned
+--SKIPIF--
+<?php require __DIR__ . "/../utils/basic-skipif.inc"; ?>
+<?php skip_if_php_version('<', '7.4.0'); ?>
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+class User implements MongoDB\BSON\PropertyCodec
+{
+    public string $name;
+    public float $score;
+
+    public function __get($name)
+    {
+        return "__get($name)";
+    }
+}
+
+$user = toPHP(fromPHP(['name' => 'Jane']), ['root' => 'User']);
+var_dump($user->name);
+
+/* Unsetting a hydrated typed property defers to __get(), as it would after a
+ * regular assignment */
+unset($user->name);
+var_dump($user->name);
+
+/* Decoding stops at the first property that rejects its value */
+try {
+    toPHP(fromPHP(['name' => ['not', 'a', 'string'], 'score' => ['not', 'a', 'float']]), ['root' => 'User']);
+} catch (TypeError $e) {
+    echo get_class($e), "\n";
+    var_dump(strpos($e->getMessage(), '$name') !== false);
+    var_dump($e->getPrevious());
+}
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+string(4) "Jane"
+string(11) "__get(name)"
+TypeError
+bool(true)
+NULL
+===DONE===
@@ -0,0 +1,34 @@
+--TEST--
+MongoDB\BSON\PropertyCodec encodes hooked properties through their get hook
+--SKIPIF--
+<?php require __DIR__ . "/../utils/basic-skipif.inc"; ?>
+<?php skip_if_php_version('<', '8.4.0'); ?>
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+class Temperature implements MongoDB\BSON\PropertyCodec
+{
+    public float $celsius = 20.0;
+
+    /* Virtual properties have no backing slot and are not encoded */
+    public float $fahrenheit {
+        get => $this->celsius * 9 / 5 + 32;
+    }
+
+    public string $unit = 'c' {
+        get => strtoupper($this->unit);
+    }
+}
+
+echo toJSON(fromPHP(new Temperature)), "\n";
+echo toJSON(fromPHP(['t' => new Temperature])), "\n";
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+{ "celsius" : 20.0, "unit" : "C" }
+{ "t" : { "celsius" : 20.0, "unit" : "C" } }
+===DONE===
@@ -0,0 +1,53 @@
+--TEST--
+MongoDB\BSON\PropertyCodec maps properties of every visibility except parent private properties
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+class Base implements MongoDB\BSON\PropertyCodec
+{
+    public $basePublic = 'basePublic';
+    protected $baseProtected = 'baseProtected';
+    private $basePrivate = 'basePrivate';
+
+    public function getBasePrivate()
+    {
+        return $this->basePrivate;
+    }
+}
+
+class Child extends Base
+{
+    public $childPublic = 'childPublic';
+    protected $childProtected = 'childProtected';
+    private $childPrivate = 'childPrivate';
+}
+
+class PlainChild
+{
+    public $childPublic = 'childPublic';
+    protected $childProtected = 'childProtected';
+    private $childPrivate = 'childPrivate';
+}
+
+/* Protected and private properties are only encoded for PropertyCodec classes */
+echo toJSON(fromPHP(new PlainChild)), "\n";
+echo toJSON(fromPHP(new Base)), "\n";
+
+/* Private properties of a parent class are neither encoded nor hydrated */
+$bson = fromPHP(new Child);
+echo toJSON($bson), "\n";
+
+$child = toPHP(fromPHP(['basePrivate' => 'decoded', 'childPrivate' => 'decoded']), ['root' => 'Child']);
+var_dump($child->getBasePrivate());
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+{ "childPublic" : "childPublic" }
+{ "basePublic" : "basePublic", "baseProtected" : "baseProtected", "basePrivate" : "basePrivate" }
+{ "basePublic" : "basePublic", "baseProtected" : "baseProtected", "childPublic" : "childPublic", "childProtected" : "childProtected", "childPrivate" : "childPrivate" }
+string(11) "basePrivate"
+===DONE===
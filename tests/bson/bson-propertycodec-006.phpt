@@ -0,0 +1,59 @@
+--TEST--
+MongoDB\BSON\PropertyCodec hydrates hooked properties through their set hook
+--SKIPIF--
+<?php require __DIR__ . "/../utils/basic-skipif.inc"; ?>
+<?php skip_if_php_version('<', '8.4.0'); ?>
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+class Temperature implements MongoDB\BSON\PropertyCodec
+{
+    public float $celsius = 20.0;
+
+    /* Virtual properties have no backing slot and are not hydrated */
+    public float $fahrenheit {
+        get => $this->celsius * 9 / 5 + 32;
+        set {
+            echo "fahrenheit set hook called\n";
+            $this->celsius = ($value - 32) * 5 / 9;
+        }
+    }
+
+    public string $unit = 'C' {
+        set {
+            echo "unit set hook called\n";
+            $this->unit = strtoupper($value);
+        }
+    }
+
+    public int $precision = 1 {
+        set {
+            if ($value < 0) {
+                throw new InvalidArgumentException('precision must not be negative');
+            }
+            $this->precision = $value;
+        }
+    }
+}
+
+$temperature = toPHP(fromPHP(['celsius' => 30.0, 'fahrenheit' => 0.0, 'unit' => 'k']), ['root' => 'Temperature']);
+var_dump($temperature->celsius, $temperature->unit);
+
+/* An exception thrown by a set hook stops decoding */
+try {
+    toPHP(fromPHP(['precision' => -1, 'unit' => 'f']), ['root' => 'Temperature']);
+} catch (InvalidArgumentException $e) {
+    echo $e->getMessage(), "\n";
+}
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+unit set hook called
+float(30)
+string(1) "K"
+precision must not be negative
+===DONE===
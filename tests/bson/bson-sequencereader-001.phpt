@@ -0,0 +1,68 @@
+--TEST--
+MongoDB\BSON\SequenceReader reads a sequence of documents from a stream
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+$documents = [['_id' => 1, 'x' => 'a'], ['_id' => 2, 'x' => str_repeat('b', 5000)], ['_id' => 3]];
+
+$stream = fopen('php://memory', 'w+');
+
+foreach ($documents as $document) {
+    fwrite($stream, fromPHP($document));
+}
+
+$typeMaps = [
+    null,
+    ['root' => 'array'],
+    ['root' => 'raw'],
+];
+
+foreach ($typeMaps as $typeMap) {
+    rewind($stream);
+
+    foreach (new MongoDB\BSON\SequenceReader($stream, $typeMap) as $key => $document) {
+        if (is_string($document)) {
+            var_dump($key, $document === fromPHP($documents[$key]));
+        } else {
+            var_dump($key, gettype($document), ((array) $document) === $documents[$key]);
+        }
+    }
+}
+
+echo "Empty stream:\n";
+foreach (new MongoDB\BSON\SequenceReader(fopen('php://memory', 'r')) as $document) {
+    var_dump($document);
+}
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+int(0)
+string(6) "object"
+bool(true)
+int(1)
+string(6) "object"
+bool(true)
+int(2)
+string(6) "object"
+bool(true)
+int(0)
+string(5) "array"
+bool(true)
+int(1)
+string(5) "array"
+bool(true)
+int(2)
+string(5) "array"
+bool(true)
+int(0)
+bool(true)
+int(1)
+bool(true)
+int(2)
+bool(true)
+Empty stream:
+===DONE===
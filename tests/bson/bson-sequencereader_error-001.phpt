@@ -0,0 +1,47 @@
+--TEST--
+MongoDB\BSON\SequenceReader errors
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+function create_stream(string $data)
+{
+    $stream = fopen('php://memory', 'w+');
+    fwrite($stream, $data);
+    rewind($stream);
+
+    return $stream;
+}
+
+$bson = fromPHP(['x' => 1]);
+
+/* The second document is truncated */
+$reader = new MongoDB\BSON\SequenceReader(create_stream($bson . substr($bson, 0, 6)));
+
+echo throws(function() use ($reader) {
+    foreach ($reader as $key => $document) {
+        var_dump($key);
+    }
+}, 'MongoDB\Driver\Exception\UnexpectedValueException'), "\n";
+
+echo throws(function() use ($reader) {
+    $reader->rewind();
+}, 'MongoDB\Driver\Exception\LogicException'), "\n";
+
+echo throws(function() {
+    new MongoDB\BSON\SequenceReader(create_stream($GLOBALS['bson']), ['root' => 'NotAClass']);
+}, 'MongoDB\Driver\Exception\InvalidArgumentException'), "\n";
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+int(0)
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Could not read BSON document at offset 12
+OK: Got MongoDB\Driver\Exception\LogicException
+MongoDB\BSON\SequenceReader cannot rewind after starting iteration
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+Class NotAClass does not exist
+===DONE===
@@ -0,0 +1,50 @@
+--TEST--
+MongoDB\BSON\SequenceWriter writes a sequence of documents to a stream
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+$stream = fopen('php://memory', 'w+');
+
+/* A small buffer is flushed while writing */
+$writer = new MongoDB\BSON\SequenceWriter($stream, 64);
+
+$writer->write(['_id' => 1, 'x' => 'a']);
+var_dump(ftell($stream));
+
+$writer->write((object) ['_id' => 2, 'x' => str_repeat('b', 100)]);
+var_dump(ftell($stream));
+
+/* Documents and BSON strings are copied as-is */
+$writer->write(MongoDB\BSON\Document::fromPHP(['_id' => 3]));
+$writer->write(fromPHP(['_id' => 4]));
+var_dump(ftell($stream));
+
+$writer->flush();
+var_dump(ftell($stream));
+
+/* Remaining documents are written when the writer is destroyed */
+$writer->write(['_id' => 5]);
+unset($writer);
+
+rewind($stream);
+
+foreach (new MongoDB\BSON\SequenceReader($stream, ['root' => 'array']) as $document) {
+    echo json_encode($document), "\n";
+}
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+int(0)
+int(145)
+int(145)
+int(173)
+{"_id":1,"x":"a"}
+{"_id":2,"x":"bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb"}
+{"_id":3}
+{"_id":4}
+{"_id":5}
+===DONE===
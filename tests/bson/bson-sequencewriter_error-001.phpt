@@ -0,0 +1,67 @@
+--TEST--
+MongoDB\BSON\SequenceWriter errors
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+$stream = fopen('php://memory', 'w+');
+$writer = new MongoDB\BSON\SequenceWriter($stream);
+
+echo throws(function() use ($writer) {
+    $writer->write(1);
+}, 'MongoDB\Driver\Exception\InvalidArgumentException'), "\n";
+
+echo throws(function() use ($writer) {
+    $writer->write(fromPHP(['x' => 1]) . 'trailing');
+}, 'MongoDB\Driver\Exception\UnexpectedValueException'), "\n";
+
+echo throws(function() {
+    new MongoDB\BSON\SequenceWriter(fopen('php://memory', 'w'), 0);
+}, 'MongoDB\Driver\Exception\InvalidArgumentException'), "\n";
+
+/* A document that fails to encode is not written */
+echo throws(function() use ($writer) {
+    $writer->write(['x' => 1, 'y' => "\xff"]);
+}, 'MongoDB\Driver\Exception\UnexpectedValueException'), "\n";
+
+$writer->write(['x' => 1]);
+$writer->flush();
+var_dump(ftell($stream));
+
+/* Buffered documents cannot be written once the stream is closed */
+$writer->write(['x' => 2]);
+fclose($stream);
+
+echo throws(function() use ($writer) {
+    $writer->flush();
+}, 'MongoDB\Driver\Exception\RuntimeException'), "\n";
+
+/* Further documents are refused until a flush succeeds */
+echo throws(function() use ($writer) {
+    $writer->write(['x' => 3]);
+}, 'MongoDB\Driver\Exception\LogicException'), "\n";
+
+/* The destructor reports documents that could not be written with a warning */
+$writer = null;
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECTF--
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+Expected document to be an array, object, or BSON string, %s given
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Expected string to contain exactly one BSON document
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+Expected bufferSize to be a positive 32-bit integer, 0 given
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected invalid UTF-8 for field path "y": %s
+int(12)
+OK: Got MongoDB\Driver\Exception\RuntimeException
+Could not write BSON documents: the stream was closed
+OK: Got MongoDB\Driver\Exception\LogicException
+MongoDB\BSON\SequenceWriter cannot write documents until flush() succeeds
+
+Warning: %SCould not write BSON documents: the stream was closed in %s on line %d
+===DONE===
@@ -0,0 +1,98 @@
+--TEST--
+MongoDB\BSON\SequenceWriter short writes and reentrant calls
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+class QuotaStream
+{
+    public static $quota = 0;
+    public static $data = '';
+    public $context;
+
+    public function stream_open($path, $mode, $options, &$openedPath)
+    {
+        return true;
+    }
+
+    public function stream_write($data)
+    {
+        $length = min(strlen($data), self::$quota);
+        self::$quota -= $length;
+        self::$data .= substr($data, 0, $length);
+
+        return $length;
+    }
+}
+
+class Reentrant implements MongoDB\BSON\Serializable
+{
+    private $callback;
+
+    public function __construct(callable $callback)
+    {
+        $this->callback = $callback;
+    }
+
+    #[\ReturnTypeWillChange]
+    public function bsonSerialize()
+    {
+        ($this->callback)();
+
+        return ['x' => 1];
+    }
+}
+
+stream_wrapper_register('quota', 'QuotaStream');
+
+$writer = new MongoDB\BSON\SequenceWriter(fopen('quota://', 'w'));
+$writer->write(['x' => 1]);
+$writer->write(['x' => 2]);
+
+/* Bytes written before a short write are not written again */
+QuotaStream::$quota = 10;
+
+echo throws(function() use ($writer) {
+    $writer->flush();
+}, 'MongoDB\Driver\Exception\RuntimeException'), "\n";
+
+/* Documents are refused until the buffered documents are written */
+echo throws(function() use ($writer) {
+    $writer->write(['x' => 3]);
+}, 'MongoDB\Driver\Exception\LogicException'), "\n";
+
+QuotaStream::$quota = 100;
+$writer->flush();
+var_dump(QuotaStream::$data === fromPHP(['x' => 1]) . fromPHP(['x' => 2]));
+
+/* The writer cannot be used while it is encoding a document */
+$writer->write(new Reentrant(function() use ($writer) {
+    echo throws(function() use ($writer) {
+        $writer->write(['y' => 1]);
+    }, 'MongoDB\Driver\Exception\LogicException'), "\n";
+
+    echo throws(function() use ($writer) {
+        $writer->flush();
+    }, 'MongoDB\Driver\Exception\LogicException'), "\n";
+}));
+
+QuotaStream::$data = '';
+$writer->flush();
+var_dump(QuotaStream::$data === fromPHP(['x' => 1]));
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+OK: Got MongoDB\Driver\Exception\RuntimeException
+Could not write 14 bytes of BSON documents to the stream
+OK: Got MongoDB\Driver\Exception\LogicException
+MongoDB\BSON\SequenceWriter cannot write documents until flush() succeeds
+bool(true)
+OK: Got MongoDB\Driver\Exception\LogicException
+MongoDB\BSON\SequenceWriter cannot be used while a document is being written
+OK: Got MongoDB\Driver\Exception\LogicException
+MongoDB\BSON\SequenceWriter cannot be used while a document is being written
+bool(true)
+===DONE===
@@ -0,0 +1,102 @@
+--TEST--
+MongoDB\BSON\toPHP(): Decoding documents with numeric field names
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+class MyDocument implements MongoDB\BSON\Unserializable
+{
+    public function bsonUnserialize(array $data)
+    {
+        var_dump($data);
+    }
+}
+
+$bson = fromJSON('{ "0": "foo", "1": { "2": "bar", "x": { "3": "baz" } }, "y": [ { "4": "qux" } ] }');
+
+echo "Default type map:\n";
+var_dump(toPHP($bson));
+
+echo "\nArray type map for documents:\n";
+var_dump(toPHP($bson, ['root' => 'array', 'document' => 'array']));
+
+echo "\nUnserializable receives an array with integer keys:\n";
+toPHP($bson, ['root' => 'MyDocument']);
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECTF--
+Default type map:
+object(stdClass)#%d (%d) {
+  ["0"]=>
+  string(3) "foo"
+  ["1"]=>
+  object(stdClass)#%d (%d) {
+    ["2"]=>
+    string(3) "bar"
+    ["x"]=>
+    object(stdClass)#%d (%d) {
+      ["3"]=>
+      string(3) "baz"
+    }
+  }
+  ["y"]=>
+  array(1) {
+    [0]=>
+    object(stdClass)#%d (%d) {
+      ["4"]=>
+      string(3) "qux"
+    }
+  }
+}
+
+Array type map for documents:
+array(3) {
+  [0]=>
+  string(3) "foo"
+  [1]=>
+  array(2) {
+    [2]=>
+    string(3) "bar"
+    ["x"]=>
+    array(1) {
+      [3]=>
+      string(3) "baz"
+    }
+  }
+  ["y"]=>
+  array(1) {
+    [0]=>
+    array(1) {
+      [4]=>
+      string(3) "qux"
+    }
+  }
+}
+
+Unserializable receives an array with integer keys:
+array(3) {
+  [0]=>
+  string(3) "foo"
+  [1]=>
+  object(stdClass)#%d (%d) {
+    ["2"]=>
+    string(3) "bar"
+    ["x"]=>
+    object(stdClass)#%d (%d) {
+      ["3"]=>
+      string(3) "baz"
+    }
+  }
+  ["y"]=>
+  array(1) {
+    [0]=>
+    object(stdClass)#%d (%d) {
+      ["4"]=>
+      string(3) "qux"
+    }
+  }
+}
+===DONE===
@@ -0,0 +1,56 @@
+--TEST--
+MongoDB\BSON\toPHP(): fieldPath typemaps prefer the first matching entry
+--FILE--
+<?php
+
+require_once __DIR__ . "/../utils/basic.inc";
+
+$bson = fromPHP([
+    'a' => [
+        'b' => ['c' => 1],
+        'd' => ['c' => 2],
+    ],
+]);
+
+$typeMaps = [
+    'wildcard first' => ['fieldPaths' => [
+        'a.$.c' => 'array',
+        'a.$'   => 'array',
+        'a.b'   => 'object',
+        '$.b'   => 'object',
+    ]],
+    'exact first' => ['fieldPaths' => [
+        'a.b'   => 'object',
+        '$.b'   => 'array',
+        'a.$'   => 'array',
+    ]],
+    'wildcard before exact' => ['fieldPaths' => [
+        '$.$'   => 'array',
+        'a.b'   => 'object',
+    ]],
+];
+
+foreach ($typeMaps as $name => $typeMap) {
+    echo $name, "\n";
+
+    /* Decode twice to exercise the compiled type map being reused */
+    for ($i = 0; $i < 2; $i++) {
+        $document = toPHP($bson, $typeMap);
+        printf("a.b: %s, a.d: %s\n", gettype($document->a->b), gettype($document->a->d));
+    }
+}
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+wildcard first
+a.b: array, a.d: array
+a.b: array, a.d: array
+exact first
+a.b: object, a.d: array
+a.b: object, a.d: array
+wildcard before exact
+a.b: array, a.d: array
+a.b: array, a.d: array
+===DONE===
@@ -0,0 +1,38 @@
+--TEST--
+MongoDB\BSON\toPHP(): Type map with "bson" returns Document and PackedArray instances
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+$bson = fromPHP(['a' => ['b' => ['c' => 1]], 'list' => [1, 2]]);
+
+$document = toPHP($bson, ['root' => 'bson']);
+var_dump(get_class($document));
+var_dump((string) $document === $bson);
+
+$document = toPHP($bson, ['document' => 'bson', 'array' => 'bson']);
+var_dump(get_class($document->a));
+var_dump(get_class($document->list));
+
+$document = toPHP($bson, ['fieldPaths' => ['a.b' => 'bson']]);
+var_dump(get_class($document->a));
+var_dump(get_class($document->a->b));
+
+/* Documents and arrays are encoded as-is */
+echo toJSON(fromPHP(['x' => $document->a->b, 'y' => MongoDB\BSON\PackedArray::fromPHP([1])])), "\n";
+echo toJSON(fromPHP(MongoDB\BSON\Document::fromPHP(['z' => true]))), "\n";
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+string(21) "MongoDB\BSON\Document"
+bool(true)
+string(21) "MongoDB\BSON\Document"
+string(24) "MongoDB\BSON\PackedArray"
+string(8) "stdClass"
+string(21) "MongoDB\BSON\Document"
+{ "x" : { "c" : 1 }, "y" : [ 1 ] }
+{ "z" : true }
+===DONE===
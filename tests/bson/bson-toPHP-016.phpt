@@ -0,0 +1,47 @@
+--TEST--
+MongoDB\BSON\toPHP(): ODM classes are resolved once per request
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+class MyPersistable implements MongoDB\BSON\Persistable
+{
+    public $data;
+
+    public function bsonSerialize()
+    {
+        return ['x' => 1];
+    }
+
+    public function bsonUnserialize(array $data)
+    {
+        $this->data = $data['x'];
+    }
+}
+
+spl_autoload_register(function($class) {
+    echo "autoload: $class\n";
+});
+
+$bson = fromPHP([
+    'a' => [new MyPersistable, new MyPersistable],
+    'b' => [
+        ['__pclass' => new MongoDB\BSON\Binary('MissingClass', 0x80)],
+        ['__pclass' => new MongoDB\BSON\Binary('MissingClass', 0x80)],
+    ],
+]);
+
+for ($i = 0; $i < 2; $i++) {
+    $document = toPHP($bson);
+    printf("%s, %s, %s\n", get_class($document->a[0]), get_class($document->a[1]), get_class($document->b[1]));
+}
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+autoload: MissingClass
+MyPersistable, MyPersistable, stdClass
+MyPersistable, MyPersistable, stdClass
+===DONE===
@@ -0,0 +1,48 @@
+--TEST--
+MongoDB\BSON\toPHP(): include and exclude typemap keys filter decoded fields
+--FILE--
+<?php
+
+require_once __DIR__ . "/../utils/basic.inc";
+
+$bson = fromPHP([
+    '_id' => 1,
+    'name' => 'foo',
+    'address' => ['city' => 'bar', 'zip' => '12345'],
+    'tags' => [['name' => 'a', 'score' => 1], ['name' => 'b', 'score' => 2]],
+]);
+
+$typeMaps = [
+    'include top-level' => ['root' => 'array', 'include' => ['_id', 'name']],
+    'include nested' => ['root' => 'array', 'document' => 'array', 'include' => ['address.city']],
+    'include within array' => ['root' => 'array', 'document' => 'array', 'include' => ['tags.name']],
+    'include wildcard' => ['root' => 'array', 'document' => 'array', 'include' => ['$.city']],
+    'include nothing' => ['root' => 'array', 'include' => []],
+    'exclude top-level' => ['root' => 'array', 'document' => 'array', 'exclude' => ['address', 'tags']],
+    'exclude nested' => ['root' => 'array', 'document' => 'array', 'exclude' => ['address.zip', 'tags.score', 'name']],
+];
+
+foreach ($typeMaps as $name => $typeMap) {
+    echo $name, "\n";
+    echo json_encode(toPHP($bson, $typeMap)), "\n";
+}
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+include top-level
+{"_id":1,"name":"foo"}
+include nested
+{"address":{"city":"bar"}}
+include within array
+{"tags":[{"name":"a"},{"name":"b"}]}
+include wildcard
+{"address":{"city":"bar"},"tags":[[],[]]}
+include nothing
+[]
+exclude top-level
+{"_id":1,"name":"foo"}
+exclude nested
+{"_id":1,"address":{"city":"bar"},"tags":[{"name":"a"},{"name":"b"}]}
+===DONE===
@@ -0,0 +1,33 @@
+--TEST--
+MongoDB\BSON\toPHP(): root type "raw" returns the BSON string
+--FILE--
+<?php
+
+require_once __DIR__ . "/../utils/basic.inc";
+
+$bson = fromPHP(['x' => ['y' => 1]]);
+
+var_dump(toPHP($bson, ['root' => 'raw']) === $bson);
+
+foreach (['document', 'array'] as $key) {
+    echo throws(function() use ($bson, $key) {
+        toPHP($bson, [$key => 'raw']);
+    }, 'MongoDB\Driver\Exception\InvalidArgumentException'), "\n";
+}
+
+echo throws(function() use ($bson) {
+    toPHP($bson, ['fieldPaths' => ['x' => 'raw']]);
+}, 'MongoDB\Driver\Exception\InvalidArgumentException'), "\n";
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+bool(true)
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+The 'raw' type may only be used for the 'root' element
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+The 'raw' type may only be used for the 'root' element
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+The 'raw' type may only be used for the 'root' element
+===DONE===
@@ -0,0 +1,58 @@
+--TEST--
+MongoDB\BSON\toPHP(): "types" type map element decodes BSON values as scalars
+--SKIPIF--
+<?php if (PHP_INT_SIZE !== 8) { die('skip Only for 64-bit platform'); } ?>
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+$bson = fromPHP([
+    'oid' => new MongoDB\BSON\ObjectId('56315a7c6118fd1b920270b1'),
+    'date' => new MongoDB\BSON\UTCDateTime(1416445411987),
+    'decimal' => new MongoDB\BSON\Decimal128('1234.5678'),
+    'binary' => new MongoDB\BSON\Binary("foo", MongoDB\BSON\Binary::TYPE_GENERIC),
+    'nested' => [['oid' => new MongoDB\BSON\ObjectId('56315a7c6118fd1b920270b2')]],
+]);
+
+var_dump(toPHP($bson, [
+    'root' => 'array',
+    'document' => 'array',
+    'array' => 'array',
+    'types' => [
+        'objectId' => 'string',
+        'date' => 'int',
+        'decimal128' => 'string',
+        'binary' => 'string',
+    ],
+]));
+
+/* Types that are not listed are still decoded as objects */
+$document = toPHP($bson, ['types' => ['date' => 'int']]);
+var_dump(get_class($document->oid), $document->date);
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+array(5) {
+  ["oid"]=>
+  string(24) "56315a7c6118fd1b920270b1"
+  ["date"]=>
+  int(1416445411987)
+  ["decimal"]=>
+  string(9) "1234.5678"
+  ["binary"]=>
+  string(3) "foo"
+  ["nested"]=>
+  array(1) {
+    [0]=>
+    array(1) {
+      ["oid"]=>
+      string(24) "56315a7c6118fd1b920270b2"
+    }
+  }
+}
+string(21) "MongoDB\BSON\ObjectId"
+int(1416445411987)
+===DONE===
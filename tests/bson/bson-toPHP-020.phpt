@@ -0,0 +1,39 @@
+--TEST--
+MongoDB\BSON\toPHP(): include and exclude typemap keys with mixed exact and wildcard paths
+--FILE--
+<?php
+
+require_once __DIR__ . "/../utils/basic.inc";
+
+$bson = fromPHP([
+    'a' => ['x' => 1, 'y' => 2, 'z' => 3],
+    'b' => ['x' => 4, 'y' => 5],
+    'c' => 6,
+    'd' => [1, 2, ['y' => 7, 'z' => 8]],
+]);
+
+$typeMaps = [
+    'include exact and wildcard' => ['root' => 'array', 'document' => 'array', 'include' => ['a.x', '$.y']],
+    'include wildcard and exact' => ['root' => 'array', 'document' => 'array', 'include' => ['$.x', 'a']],
+    'exclude exact and wildcard' => ['root' => 'array', 'document' => 'array', 'exclude' => ['a.x', '$.y']],
+    'exclude exact and terminal wildcard' => ['root' => 'array', 'document' => 'array', 'exclude' => ['a.x', '$']],
+];
+
+foreach ($typeMaps as $name => $typeMap) {
+    echo $name, "\n";
+    echo json_encode(toPHP($bson, $typeMap)), "\n";
+}
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+include exact and wildcard
+{"a":{"x":1,"y":2},"b":{"y":5},"d":[{"y":7}]}
+include wildcard and exact
+{"a":{"x":1,"y":2,"z":3},"b":{"x":4},"d":[[]]}
+exclude exact and wildcard
+{"a":{"z":3},"b":{"x":4},"c":6,"d":[1,2,{"z":8}]}
+exclude exact and terminal wildcard
+[]
+===DONE===
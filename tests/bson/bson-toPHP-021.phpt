@@ -0,0 +1,45 @@
+--TEST--
+MongoDB\BSON\toPHP(): Type map with "bson" does not filter fields within Document and PackedArray instances
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+$bson = fromPHP(['a' => ['x' => 1, 'y' => 2], 'list' => [1, ['x' => 2, 'y' => 3]], 'b' => 3]);
+
+/* Filters decide whether a document is skipped, but not which of its fields
+ * are kept */
+$document = toPHP($bson, ['document' => 'bson', 'array' => 'bson', 'include' => ['a.x', 'list.x']]);
+var_dump(array_keys((array) $document));
+echo toJSON((string) $document->a), "\n";
+echo toJSON(fromPHP(['list' => $document->list])), "\n";
+
+$document = toPHP($bson, ['document' => 'bson', 'exclude' => ['a.x', 'b']]);
+var_dump(array_keys((array) $document));
+echo toJSON((string) $document->a), "\n";
+
+/* A root document returned as BSON is not filtered at all */
+$document = toPHP($bson, ['root' => 'bson', 'include' => ['b']]);
+var_dump((string) $document === $bson);
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+array(2) {
+  [0]=>
+  string(1) "a"
+  [1]=>
+  string(4) "list"
+}
+{ "x" : 1, "y" : 2 }
+{ "list" : [ 1, { "x" : 2, "y" : 3 } ] }
+array(2) {
+  [0]=>
+  string(1) "a"
+  [1]=>
+  string(4) "list"
+}
+{ "x" : 1, "y" : 2 }
+bool(true)
+===DONE===
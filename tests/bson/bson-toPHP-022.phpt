@@ -0,0 +1,38 @@
+--TEST--
+MongoDB\BSON\toPHP(): Type maps holding references are not cached
+--FILE--
+<?php
+
+require_once __DIR__ . "/../utils/basic.inc";
+
+$bson = fromPHP(['a' => ['b' => 1]]);
+
+$root = 'array';
+$typeMap = ['root' => &$root];
+echo gettype(toPHP($bson, $typeMap)), "\n";
+$root = 'object';
+echo gettype(toPHP($bson, $typeMap)), "\n";
+
+$fieldPaths = ['a' => 'array'];
+$typeMap = ['fieldPaths' => &$fieldPaths];
+echo gettype(toPHP($bson, $typeMap)->a), "\n";
+$fieldPaths['a'] = 'object';
+echo gettype(toPHP($bson, $typeMap)->a), "\n";
+
+$type = 'array';
+$typeMap = ['fieldPaths' => ['a' => &$type]];
+echo gettype(toPHP($bson, $typeMap)->a), "\n";
+$type = 'object';
+echo gettype(toPHP($bson, $typeMap)->a), "\n";
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+array
+object
+array
+object
+array
+object
+===DONE===
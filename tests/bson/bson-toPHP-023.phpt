@@ -0,0 +1,40 @@
+--TEST--
+MongoDB\BSON\toPHP(): Type maps modified in place are compiled again
+--FILE--
+<?php
+
+require_once __DIR__ . "/../utils/basic.inc";
+
+$bson = fromPHP(['a' => ['b' => 1]]);
+
+/* Modifying an array with a single reference does not separate it, so the
+ * array keeps its address while its contents change */
+$typeMap = [];
+$typeMap['root'] = 'array';
+echo gettype(toPHP($bson, $typeMap)), "\n";
+$typeMap['root'] = 'object';
+echo gettype(toPHP($bson, $typeMap)), "\n";
+
+$typeMap = ['fieldPaths' => []];
+$typeMap['fieldPaths']['a'] = 'array';
+echo gettype(toPHP($bson, $typeMap)->a), "\n";
+$typeMap['fieldPaths']['a'] = 'object';
+echo gettype(toPHP($bson, $typeMap)->a), "\n";
+
+/* Type map literals are compiled once and produce the same result */
+for ($i = 0; $i < 3; $i++) {
+    echo gettype(toPHP($bson, ['root' => 'array', 'document' => 'array'])['a']), "\n";
+}
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+array
+object
+array
+object
+array
+array
+array
+===DONE===
@@ -0,0 +1,60 @@
+--TEST--
+phpinfo() reports ODM class cache hits and misses for the request
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+class MyPersistable implements MongoDB\BSON\Persistable
+{
+    public function bsonSerialize()
+    {
+        return ['x' => 1];
+    }
+
+    public function bsonUnserialize(array $data)
+    {
+    }
+}
+
+function printOdmClassCacheCounts()
+{
+    ob_start();
+    phpinfo(INFO_MODULES);
+    $info = ob_get_clean();
+
+    preg_match_all('/^ODM class cache (hits|misses) => (\d+)$/m', $info, $matches, PREG_SET_ORDER);
+
+    foreach ($matches as $match) {
+        printf("%s: %d\n", $match[1], $match[2]);
+    }
+}
+
+printOdmClassCacheCounts();
+
+$bson = fromPHP([
+    'a' => [new MyPersistable, new MyPersistable],
+    'b' => [
+        ['__pclass' => new MongoDB\BSON\Binary('MissingClass', 0x80)],
+        ['__pclass' => new MongoDB\BSON\Binary('MissingClass', 0x80)],
+    ],
+]);
+
+/* Each class is looked up once; other __pclass fields hit the cache */
+toPHP($bson);
+printOdmClassCacheCounts();
+
+toPHP($bson);
+printOdmClassCacheCounts();
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+hits: 0
+misses: 0
+hits: 2
+misses: 2
+hits: 6
+misses: 2
+===DONE===
@@ -0,0 +1,42 @@
+--TEST--
+MongoDB\BSON\toPHP(): include and exclude typemap keys are validated
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+$typeMaps = [
+    ['include' => ['a'], 'exclude' => ['b']],
+    ['include' => 'a'],
+    ['exclude' => [1]],
+    ['include' => ['']],
+    ['include' => ['.a']],
+    ['exclude' => ['a.']],
+    ['include' => ['a..b']],
+];
+
+foreach ($typeMaps as $typeMap) {
+    echo throws(function() use ($typeMap) {
+        toPHP(fromPHP(['a' => 1]), $typeMap);
+    }, 'MongoDB\Driver\Exception\InvalidArgumentException'), "\n";
+}
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+The 'include' and 'exclude' elements cannot both be specified
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+The 'include' element is not an array
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+The 'exclude' element must contain only strings
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+The 'include' element may not contain an empty string
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+An 'include' path may not start with a '.'
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+An 'exclude' path may not end with a '.'
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+An 'include' path may not have an empty segment
+===DONE===
@@ -0,0 +1,36 @@
+--TEST--
+MongoDB\BSON\toPHP(): BSON decoding exceptions for malformed length prefixes
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+$tests = [
+    pack('V', 5), // Buffer shorter than the minimum document size
+    pack('Vx', 4), // Empty document with invalid length (too small)
+    pack('Vx', 6), // Empty document with invalid length (too large)
+    pack('VC', 5, 1), // Document not terminated by a null byte
+    fromPHP(['x' => 1]) . "\x00", // Trailing byte after the document
+];
+
+foreach ($tests as $bson) {
+    echo throws(function() use ($bson) {
+        toPHP($bson);
+    }, 'MongoDB\Driver\Exception\UnexpectedValueException'), "\n";
+}
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Could not read document from BSON reader
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Could not read document from BSON reader
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Could not read document from BSON reader
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Could not read document from BSON reader
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Reading document did not exhaust input buffer
+===DONE===
@@ -0,0 +1,30 @@
+--TEST--
+MongoDB\BSON\toPHP(): BSON decoding exceptions report nested field paths
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+$bson = fromPHP(['a' => 1, 'b' => ['x', ['c' => 'd']]]);
+$bson[strpos($bson, "c\x00") - 1] = chr(0x42);
+
+$typeMaps = [
+    [],
+    ['fieldPaths' => ['b.1' => 'array']],
+];
+
+foreach ($typeMaps as $typeMap) {
+    echo throws(function() use ($bson, $typeMap) {
+        toPHP($bson, $typeMap);
+    }, 'MongoDB\Driver\Exception\UnexpectedValueException'), "\n";
+}
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected unknown BSON type 0x42 for field path "b.1.c". Are you using the latest driver?
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected unknown BSON type 0x42 for field path "b.1.c". Are you using the latest driver?
+===DONE===
@@ -0,0 +1,36 @@
+--TEST--
+MongoDB\BSON\toPHP(): "types" type map element errors
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+$typeMaps = [
+    ['types' => 'string'],
+    ['types' => ['string']],
+    ['types' => ['int64' => 'string']],
+    ['types' => ['objectId' => 'int']],
+    ['types' => ['date' => 'string']],
+];
+
+foreach ($typeMaps as $typeMap) {
+    echo throws(function() use ($typeMap) {
+        toPHP(fromPHP([]), $typeMap);
+    }, 'MongoDB\Driver\Exception\InvalidArgumentException'), "\n";
+}
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+The 'types' element is not an array
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+The 'types' element must be an associative array
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+The 'types' element contains an unsupported BSON type: 'int64'
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+The 'objectId' type may only be mapped to 'string'
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+The 'date' type may only be mapped to 'int'
+===DONE===
@@ -0,0 +1,27 @@
+--TEST--
+MongoDB\BSON\toPHP(): "types" type map element cannot map dates to integers on 32-bit platforms
+--SKIPIF--
+<?php if (4 !== PHP_INT_SIZE) { die('skip Only for 32-bit platform'); } ?>
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/basic.inc';
+
+echo throws(function() {
+    toPHP(fromPHP(['date' => new MongoDB\BSON\UTCDateTime(1416445411987)]), ['types' => ['date' => 'int']]);
+}, 'MongoDB\Driver\Exception\InvalidArgumentException'), "\n";
+
+/* Other types may still be mapped */
+var_dump(toPHP(fromPHP(['oid' => new MongoDB\BSON\ObjectId('56315a7c6118fd1b920270b1')]), ['types' => ['objectId' => 'string']]));
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECTF--
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+The 'date' type cannot be mapped to 'int' on 32-bit platforms
+object(stdClass)#%d (1) {
+  ["oid"]=>
+  string(24) "56315a7c6118fd1b920270b1"
+}
+===DONE===
@@ -0,0 +1,42 @@
+--TEST--
+MongoDB\Driver\BulkWrite::insert() and update() with documents of varying size
+--SKIPIF--
+<?php require __DIR__ . "/../utils/basic-skipif.inc"; ?>
+<?php skip_if_not_live(); ?>
+<?php skip_if_not_clean(); ?>
+--FILE--
+<?php
+require_once __DIR__ . "/../utils/basic.inc";
+
+$manager = create_test_manager();
+
+$bulk = new MongoDB\Driver\BulkWrite();
+
+/* Larger documents are followed by smaller ones, which are encoded into a
+ * buffer sized for the largest document seen so far. */
+foreach ([50000, 10, 5000, 1] as $i => $size) {
+    $bulk->insert(['_id' => $i, 'x' => str_repeat('a', $size)]);
+}
+
+$bulk->update(['_id' => 2], ['_id' => 2, 'x' => 'b']);
+$bulk->update(['_id' => 3], ['$set' => ['x' => str_repeat('c', 20000)]]);
+
+$result = $manager->executeBulkWrite(NS, $bulk);
+printf("Inserted %d, modified %d document(s)\n", $result->getInsertedCount(), $result->getModifiedCount());
+
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([]));
+
+foreach ($cursor as $document) {
+    printf("%d: %s x %d\n", $document->_id, $document->x[0], strlen($document->x));
+}
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+Inserted 4, modified 2 document(s)
+0: a x 50000
+1: a x 10
+2: b x 1
+3: c x 20000
+===DONE===
@@ -0,0 +1,29 @@
+--TEST--
+MongoDB\Driver\BulkWrite::insert() with one large document among many small ones
+--FILE--
+<?php
+require_once __DIR__ . "/../utils/basic.inc";
+
+$bulk = new MongoDB\Driver\BulkWrite();
+$large = str_repeat('a', 8 * 1024 * 1024);
+
+$before = memory_get_usage();
+
+/* The size estimate for later documents decays after the large one, which is
+ * encoded without keeping a buffer of its size for the rest of the request */
+$bulk->insert(['x' => $large]);
+
+for ($i = 0; $i < 1000; $i++) {
+    $bulk->insert(['x' => $i]);
+}
+
+var_dump(count($bulk));
+var_dump(memory_get_usage() - $before <= 5 * 1024 * 1024);
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+int(1001)
+bool(true)
+===DONE===
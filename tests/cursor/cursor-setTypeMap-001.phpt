@@ -0,0 +1,35 @@
+--TEST--
+MongoDB\Driver\Cursor::setTypeMap(): root type "raw" returns BSON strings
+--SKIPIF--
+<?php require __DIR__ . "/../utils/basic-skipif.inc"; ?>
+<?php skip_if_not_live(); ?>
+<?php skip_if_not_clean(); ?>
+--FILE--
+<?php
+
+require_once __DIR__ . "/../utils/basic.inc";
+
+$manager = create_test_manager();
+
+$bulk = new MongoDB\Driver\BulkWrite();
+$bulk->insert(['_id' => 1, 'x' => ['y' => 'a']]);
+$bulk->insert(['_id' => 2, 'x' => ['y' => 'b']]);
+$manager->executeBulkWrite(NS, $bulk);
+
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([]));
+$cursor->setTypeMap(['root' => 'raw']);
+
+foreach ($cursor as $document) {
+    var_dump(is_string($document));
+    echo toJSON($document), "\n";
+}
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+bool(true)
+{ "_id" : 1, "x" : { "y" : "a" } }
+bool(true)
+{ "_id" : 2, "x" : { "y" : "b" } }
+===DONE===
@@ -0,0 +1,55 @@
+--TEST--
+MongoDB\Driver\Cursor::toArray() decodes field names shared between documents
+--SKIPIF--
+<?php require __DIR__ . "/../utils/basic-skipif.inc"; ?>
+<?php skip_if_not_live(); ?>
+<?php skip_if_not_clean(); ?>
+--FILE--
+<?php
+
+require_once __DIR__ . "/../utils/basic.inc";
+
+$manager = create_test_manager();
+
+$bulk = new MongoDB\Driver\BulkWrite();
+$bulk->insert(['_id' => 1, 'x' => ['0' => 'a', 'y' => 'b']]);
+$bulk->insert(['_id' => 2, 'x' => ['0' => 'c', 'y' => 'd']]);
+$manager->executeBulkWrite(NS, $bulk);
+
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([]));
+$cursor->setTypeMap(['root' => 'array']);
+
+foreach ($cursor as $i => $document) {
+    var_dump($document);
+
+    /* Switching type maps during iteration reuses the same field names */
+    $cursor->setTypeMap($i % 2 ? ['root' => 'array'] : ['root' => 'array', 'document' => 'array']);
+}
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECTF--
+array(2) {
+  ["_id"]=>
+  int(1)
+  ["x"]=>
+  object(stdClass)#%d (%d) {
+    ["0"]=>
+    string(1) "a"
+    ["y"]=>
+    string(1) "b"
+  }
+}
+array(2) {
+  ["_id"]=>
+  int(2)
+  ["x"]=>
+  array(2) {
+    [0]=>
+    string(1) "c"
+    ["y"]=>
+    string(1) "d"
+  }
+}
+===DONE===
@@ -0,0 +1,49 @@
+--TEST--
+MongoDB\Driver\Cursor::toArray() collects documents across getMore batches
+--SKIPIF--
+<?php require __DIR__ . "/../utils/basic-skipif.inc"; ?>
+<?php skip_if_not_live(); ?>
+<?php skip_if_not_clean(); ?>
+--FILE--
+<?php
+
+require_once __DIR__ . "/../utils/basic.inc";
+
+$manager = create_test_manager();
+
+$bulk = new MongoDB\Driver\BulkWrite();
+for ($i = 0; $i < 5; $i++) {
+    $bulk->insert(['_id' => $i]);
+}
+$manager->executeBulkWrite(NS, $bulk);
+
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([], ['batchSize' => 2]));
+$cursor->setTypeMap(['root' => 'array']);
+
+$documents = $cursor->toArray();
+
+var_dump(array_keys($documents) === range(0, 4));
+var_dump(array_column($documents, '_id'));
+var_dump($cursor->isDead());
+var_dump($cursor->valid());
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+bool(true)
+array(5) {
+  [0]=>
+  int(0)
+  [1]=>
+  int(1)
+  [2]=>
+  int(2)
+  [3]=>
+  int(3)
+  [4]=>
+  int(4)
+}
+bool(true)
+bool(false)
+===DONE===